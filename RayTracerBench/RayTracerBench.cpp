@@ -0,0 +1,614 @@
+#define CATCH_CONFIG_MAIN
+
+#include <sstream>
+#include <vector>
+
+#include <Catch2/catch.hpp>
+
+#include <RayTracerLib/AffineTransform.h>
+#include <RayTracerLib/Canvas.h>
+#include <RayTracerLib/MatrixBatch.h>
+#include <RayTracerLib/MatrixExpression.h>
+#include <RayTracerLib/Quaternion.h>
+#include <RayTracerLib/Matrix.h>
+#include <RayTracerLib/Tuple.h>
+
+// Benchmarks are only meaningful in an optimized build, for example:
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build && build/bin/RayTracerBench
+// Compare RAYTRACER_HEADER_ONLY_MATH=ON and OFF builds with the [math-core] benchmarks, they call the parts of the
+// math core that are out of line in the library build.
+// Each benchmark works on BENCH_ELEMENT_COUNT elements, divide the reported mean by it for the per-element cost.
+
+constexpr size_t BENCH_ELEMENT_COUNT = 4096;
+
+namespace {
+
+std::vector<Tuple> MakePoints(const size_t count)
+{
+	std::vector<Tuple> points;
+	points.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		points.push_back(Tuple::CreatePoint(f, f * 0.5f, -f));
+	}
+
+	return points;
+}
+
+std::vector<Tuple> MakeVectors(const size_t count)
+{
+	std::vector<Tuple> vectors;
+	vectors.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		vectors.push_back(Tuple::CreateVector(1.0f + f, 2.0f - f, 0.25f * f));
+	}
+
+	return vectors;
+}
+
+std::vector<Matrix4x4> MakeTransforms(const size_t count)
+{
+	std::vector<Matrix4x4> transforms;
+	transforms.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto f = static_cast<float>(i % 64) * 0.1f;
+		transforms.push_back(Make4x4Matrix({
+			1.0f + f, 0.5f, 0.0f, f,
+			-0.5f, 2.0f, f, 1.0f,
+			0.25f, -f, 1.0f, 3.0f,
+			0.0f, 0.0f, 0.0f, 1.0f,
+		}));
+	}
+
+	return transforms;
+}
+
+// The inverse the matrix code used before the closed form, kept here for comparison.
+Matrix4x4 InverseByCofactors(const Matrix4x4& matrix)
+{
+	Matrix4x4::MatrixElementsType elements = {};
+	const auto determinant = matrix.Determinant();
+	for (size_t row = 0; row < 4; ++row)
+	{
+		for (size_t col = 0; col < 4; ++col)
+			elements[col][row] = matrix.Cofactor(row, col) / determinant;
+	}
+
+	return Matrix4x4(elements);
+}
+
+// Products and transforms written against the public element accessors, the way code outside Matrix.h reads
+// matrices.
+Matrix4x4 MultiplyByElement(const Matrix4x4& lhs, const Matrix4x4& rhs)
+{
+	Matrix4x4::MatrixElementsType elements = {};
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (size_t j = 0; j < 4; ++j)
+		{
+			for (size_t k = 0; k < 4; ++k)
+				elements[i][j] += lhs[i][k] * rhs[k][j];
+		}
+	}
+
+	return Matrix4x4(elements);
+}
+
+Tuple TransformByElement(const Matrix4x4& lhs, const Tuple& rhs)
+{
+	return {
+		rhs.x * lhs[0][0] + rhs.y * lhs[0][1] + rhs.z * lhs[0][2] + rhs.w * lhs[0][3],
+		rhs.x * lhs[1][0] + rhs.y * lhs[1][1] + rhs.z * lhs[1][2] + rhs.w * lhs[1][3],
+		rhs.x * lhs[2][0] + rhs.y * lhs[2][1] + rhs.z * lhs[2][2] + rhs.w * lhs[2][3],
+		rhs.x * lhs[3][0] + rhs.y * lhs[3][1] + rhs.z * lhs[3][2] + rhs.w * lhs[3][3]
+	};
+}
+
+template <typename Policy>
+void AddAll(const std::vector<Tuple>& lhs, const std::vector<Tuple>& rhs, std::vector<Tuple>& out)
+{
+	for (size_t i = 0; i < out.size(); ++i)
+	{
+		out[i] = Add<Policy>(lhs[i], rhs[i]);
+	}
+}
+
+// The stringstream P3 encoder ToPpm used before the lookup table, kept here for comparison.
+std::string ToPpmWithStringStream(const Canvas& canvas)
+{
+	auto addToLine = [] (std::stringstream &ppmSs, std::string& lineString, const std::string& color, const size_t maxLineLength)
+	{
+		const auto newLine = '\n';
+		const auto colorString = lineString.empty() ? color : std::string(" ") + color;
+		const auto newLineBeforeColor = lineString.length() >= (maxLineLength - colorString.length());
+		if (newLineBeforeColor)
+		{
+			ppmSs << lineString << newLine;
+			lineString.clear();
+			lineString += color;
+		}
+		else
+		{
+			lineString += colorString;
+		}	
+	};
+	std::stringstream ppmSs;
+	std::string lineString;
+	const auto newLine = '\n';
+	ppmSs << "P3" << newLine
+		<< canvas.width << " " << canvas.height << newLine
+		<< 255 << newLine
+	;
+	//PPM file lines should not be longer than 70 chars. If we reach 70 chars before the next canvas line then break. Also break on new canvas line
+	// The max single color length is 3 (for example for 255)
+	const auto maxLineLength = static_cast<uint32_t>(70);
+	for (uint32_t y = 0; y < canvas.height; ++y)
+	{
+		for (uint32_t x = 0; x < canvas.width; ++x)
+		{
+			const auto color = canvas.PixelAt(x, y);
+			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.r)), maxLineLength);
+			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.g)), maxLineLength);
+			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.b)), maxLineLength);	
+		}
+
+		if (!lineString.empty())
+		{
+			ppmSs << lineString << newLine;
+			lineString.clear();
+		}
+	}
+
+	if (!lineString.empty())
+	{
+		ppmSs << lineString << newLine;
+		lineString.clear();
+	}
+
+	return ppmSs.str();
+}
+
+}
+
+TEST_CASE( "Tuple addition", "[tuple][benchmark]" )
+{
+	const auto points = MakePoints(BENCH_ELEMENT_COUNT);
+	const auto vectors = MakeVectors(BENCH_ELEMENT_COUNT);
+	std::vector<Tuple> out(BENCH_ELEMENT_COUNT);
+
+	BENCHMARK("4096 checked point + vector adds")
+	{
+		AddAll<CheckedTupleArithmetic>(points, vectors, out);
+		return out.back().x;
+	};
+
+	BENCHMARK("4096 unchecked point + vector adds")
+	{
+		AddAll<UncheckedTupleArithmetic>(points, vectors, out);
+		return out.back().x;
+	};
+}
+
+TEST_CASE( "Tuple normalization", "[tuple][benchmark]" )
+{
+	const auto vectors = MakeVectors(BENCH_ELEMENT_COUNT);
+	std::vector<Tuple> out(BENCH_ELEMENT_COUNT);
+
+	BENCHMARK("4096 precise normalizations")
+	{
+		for (size_t i = 0; i < vectors.size(); ++i)
+			out[i] = vectors[i].Normalize<PreciseNormalize>();
+		return out.back().x;
+	};
+
+	BENCHMARK("4096 fast normalizations")
+	{
+		for (size_t i = 0; i < vectors.size(); ++i)
+			out[i] = vectors[i].Normalize<FastNormalize>();
+		return out.back().x;
+	};
+
+	BENCHMARK("NormalizeMany over 4096 precise")
+	{
+		out = vectors;
+		NormalizeMany<PreciseNormalize>(out.data(), out.size());
+		return out.back().x;
+	};
+
+	BENCHMARK("NormalizeMany over 4096 fast")
+	{
+		out = vectors;
+		NormalizeMany<FastNormalize>(out.data(), out.size());
+		return out.back().x;
+	};
+}
+
+TEST_CASE( "Out of line math core calls", "[math-core][benchmark]" )
+{
+	const auto points = MakePoints(BENCH_ELEMENT_COUNT);
+	const auto vectors = MakeVectors(BENCH_ELEMENT_COUNT);
+	std::vector<Tuple> out(BENCH_ELEMENT_COUNT);
+
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+	WARN("Math core mode: header-only");
+#else
+	WARN("Math core mode: static library");
+#endif
+
+	BENCHMARK("4096 Equalf calls")
+	{
+		size_t equalCount = 0;
+		for (size_t i = 0; i < points.size(); ++i)
+			equalCount += Equalf(points[i].x, vectors[i].y) ? 1 : 0;
+		return equalCount;
+	};
+
+	BENCHMARK("1024 NormalizeMany calls over 4 tuples")
+	{
+		out = vectors;
+		for (size_t i = 0; i < out.size(); i += 4)
+			NormalizeMany(out.data() + i, 4);
+		return out.back().x;
+	};
+}
+
+TEST_CASE( "Transforming tuples", "[matrix][benchmark]" )
+{
+	const Matrix4x4 transform = Make4x4Matrix({
+		1.0f, 0.0f, 0.5f, 4.0f,
+		0.0f, 2.0f, 0.0f, -2.0f,
+		-0.5f, 0.0f, 1.0f, 1.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+	const auto points = MakePoints(BENCH_ELEMENT_COUNT);
+	std::vector<Tuple> out(BENCH_ELEMENT_COUNT);
+
+	std::vector<TuplePacket<NATIVE_PACKET_WIDTH>> packets(BENCH_ELEMENT_COUNT / NATIVE_PACKET_WIDTH);
+	for (size_t i = 0; i < packets.size(); ++i)
+		packets[i] = TuplePacket<NATIVE_PACKET_WIDTH>::Load(points.data() + i * NATIVE_PACKET_WIDTH);
+	std::vector<TuplePacket<NATIVE_PACKET_WIDTH>> outPackets(packets.size());
+
+	BENCHMARK("4096 matrix * point")
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+			out[i] = transform * points[i];
+		return out.back().x;
+	};
+
+	BENCHMARK("TransformPoints over 4096")
+	{
+		TransformPoints(transform, points.data(), out.data(), points.size());
+		return out.back().x;
+	};
+
+	BENCHMARK("TransformPoints over 4096 in packets")
+	{
+		TransformPoints(transform, packets.data(), outPackets.data(), packets.size());
+		return outPackets.back().x[0];
+	};
+}
+
+TEST_CASE( "Matrix inversion", "[matrix][benchmark]" )
+{
+	const auto transforms = MakeTransforms(BENCH_ELEMENT_COUNT);
+	std::vector<Matrix4x4> out(BENCH_ELEMENT_COUNT, Matrix4x4::Identity());
+
+	BENCHMARK("4096 4x4 inverses by cofactor expansion")
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+			out[i] = InverseByCofactors(transforms[i]);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("4096 closed-form 4x4 inverses")
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+			out[i] = Inverse4x4(transforms[i]);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("4096 4x4 inverses")
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+			out[i] = transforms[i].Inverse();
+		return out.back()[0][0];
+	};
+
+}
+
+TEST_CASE( "Matrix multiplication", "[matrix][benchmark]" )
+{
+	const auto transforms = MakeTransforms(BENCH_ELEMENT_COUNT);
+	std::vector<Matrix4x4> out(BENCH_ELEMENT_COUNT, Matrix4x4::Identity());
+
+	BENCHMARK("4096 4x4 products")
+	{
+		for (size_t i = 1; i < transforms.size(); ++i)
+			out[i] = transforms[i - 1] * transforms[i];
+		return out.back()[0][0];
+	};
+}
+
+TEST_CASE( "Matrix batches", "[matrix][benchmark]" )
+{
+	constexpr size_t batchSize = 1 << 20;
+	const auto transforms = MakeTransforms(batchSize);
+	std::vector<Matrix4x4> out(batchSize, Matrix4x4::Identity());
+
+	BENCHMARK("1M 4x4 inverses one at a time")
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+			out[i] = transforms[i].Inverse();
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("1M 4x4 inverses, InvertMatrices")
+	{
+		InvertMatrices(transforms.data(), out.data(), batchSize);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("1M 4x4 inverses, InvertMatrices all threads")
+	{
+		InvertMatrices(transforms.data(), out.data(), batchSize, 0);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("1M 4x4 products one at a time")
+	{
+		for (size_t i = 0; i < transforms.size(); ++i)
+			out[i] = transforms[i] * transforms[i];
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("1M 4x4 products, ComposeMatrices")
+	{
+		ComposeMatrices(transforms.data(), transforms.data(), out.data(), batchSize);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("1M 4x4 products, ComposeMatrices all threads")
+	{
+		ComposeMatrices(transforms.data(), transforms.data(), out.data(), batchSize, 0);
+		return out.back()[0][0];
+	};
+}
+
+TEST_CASE( "Affine transforms", "[affine][benchmark]" )
+{
+	const auto transforms = MakeTransforms(BENCH_ELEMENT_COUNT);
+	std::vector<AffineTransform> affineTransforms;
+	affineTransforms.reserve(transforms.size());
+	for (const auto& transform : transforms)
+		affineTransforms.emplace_back(transform);
+	std::vector<AffineTransform> out(BENCH_ELEMENT_COUNT, AffineTransform::Identity());
+
+	BENCHMARK("4096 affine products")
+	{
+		for (size_t i = 1; i < affineTransforms.size(); ++i)
+			out[i] = affineTransforms[i - 1] * affineTransforms[i];
+		return out.back().m_elements[0][0];
+	};
+
+	BENCHMARK("4096 affine inverses")
+	{
+		for (size_t i = 0; i < affineTransforms.size(); ++i)
+			out[i] = affineTransforms[i].Inverse();
+		return out.back().m_elements[0][0];
+	};
+}
+
+TEST_CASE( "Matrix element access", "[matrix][benchmark]" )
+{
+	const auto transforms = MakeTransforms(BENCH_ELEMENT_COUNT);
+	const auto points = MakePoints(BENCH_ELEMENT_COUNT);
+	std::vector<Matrix4x4> out(BENCH_ELEMENT_COUNT, Matrix4x4::Identity());
+	std::vector<Tuple> outPoints(BENCH_ELEMENT_COUNT);
+
+	BENCHMARK("4096 4x4 products through operator[]")
+	{
+		for (size_t i = 1; i < transforms.size(); ++i)
+			out[i] = MultiplyByElement(transforms[i - 1], transforms[i]);
+		return out.back()[0][0];
+	};
+
+	BENCHMARK("4096 matrix * point through operator[]")
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+			outPoints[i] = TransformByElement(transforms[i], points[i]);
+		return outPoints.back().x;
+	};
+}
+
+TEST_CASE( "Transform chains", "[matrix][lazy][benchmark]" )
+{
+	const auto transforms = MakeTransforms(3);
+	const auto points = MakePoints(BENCH_ELEMENT_COUNT);
+	std::vector<Tuple> out(BENCH_ELEMENT_COUNT);
+
+	BENCHMARK("4096 points through an eager chain of three matrices")
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+			out[i] = transforms[0] * transforms[1] * transforms[2] * points[i];
+		return out.back().x;
+	};
+
+	BENCHMARK("4096 points through a lazy chain of three matrices")
+	{
+		for (size_t i = 0; i < points.size(); ++i)
+			out[i] = Lazy(transforms[0]) * Lazy(transforms[1]) * Lazy(transforms[2]) * points[i];
+		return out.back().x;
+	};
+}
+
+TEST_CASE( "Quaternion rotations", "[quaternion][benchmark]" )
+{
+	std::vector<Quaternion> rotations;
+	std::vector<Matrix4x4> matrices;
+	for (size_t i = 0; i < BENCH_ELEMENT_COUNT; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		rotations.push_back(Quaternion::FromAxisAngle(Tuple::CreateVector(1.0f, f, 0.5f), f * 0.01f));
+		matrices.push_back(rotations.back().ToMatrix());
+	}
+	std::vector<Quaternion> outRotations(BENCH_ELEMENT_COUNT, Quaternion::Identity());
+	std::vector<Matrix4x4> outMatrices(BENCH_ELEMENT_COUNT, Matrix4x4::Identity());
+
+	BENCHMARK("4096 rotation matrix compositions")
+	{
+		for (size_t i = 1; i < matrices.size(); ++i)
+			outMatrices[i] = matrices[i - 1] * matrices[i];
+		return outMatrices.back()[0][0];
+	};
+
+	BENCHMARK("4096 quaternion compositions")
+	{
+		for (size_t i = 1; i < rotations.size(); ++i)
+			outRotations[i] = rotations[i - 1] * rotations[i];
+		return outRotations.back().w;
+	};
+
+	BENCHMARK("4096 quaternion slerps")
+	{
+		for (size_t i = 1; i < rotations.size(); ++i)
+			outRotations[i] = Slerp(rotations[i - 1], rotations[i], 0.3f);
+		return outRotations.back().w;
+	};
+}
+
+TEST_CASE( "Canvas comparison", "[canvas][benchmark]" )
+{
+	Canvas lhs(512, 512);
+	Canvas rhs(512, 512);
+	lhs.Fill(Color(0.25f, 0.5f, 0.75f));
+	rhs.Fill(Color(0.25f, 0.5f, 0.75f));
+
+	BENCHMARK("512x512 pixels compared one by one")
+	{
+		size_t different = 0;
+		for (size_t i = 0; i < lhs.pixels.size(); ++i)
+			different += (lhs.pixels[i] != rhs.pixels[i]) ? 1 : 0;
+		return different;
+	};
+
+	BENCHMARK("512x512 pixels with CountDifferentPixels")
+	{
+		return CountDifferentPixels(lhs, rhs);
+	};
+}
+
+TEST_CASE( "Canvas layouts", "[canvas][benchmark]" )
+{
+	Canvas rowMajor(1024, 1024);
+	Canvas tiled(1024, 1024, CanvasLayout::Tiled);
+
+	// A box filter over each tile, the access pattern of tile based rendering and filtering.
+	const auto blurTiles = [](Canvas& canvas)
+	{
+		float sum = 0.0f;
+		for (const auto tile : canvas.Tiles())
+		{
+			for (uint32_t y = 1; y + 1 < tile.height; ++y)
+			{
+				for (uint32_t x = 1; x + 1 < tile.width; ++x)
+				{
+					const Color blurred = (tile.At(x - 1, y) + tile.At(x + 1, y) + tile.At(x, y - 1) + tile.At(x, y + 1))
+						* 0.25f;
+					tile.At(x, y) = blurred;
+					sum += blurred.r;
+				}
+			}
+		}
+		return sum;
+	};
+
+	BENCHMARK("1024x1024 tile filter, row-major")
+	{
+		return blurTiles(rowMajor);
+	};
+
+	BENCHMARK("1024x1024 tile filter, tiled")
+	{
+		return blurTiles(tiled);
+	};
+
+	BENCHMARK("1024x1024 WritePixel, row-major")
+	{
+		for (uint32_t y = 0; y < rowMajor.height; ++y)
+		{
+			for (uint32_t x = 0; x < rowMajor.width; ++x)
+				rowMajor.WritePixel(x, y, Color(0.5f, 0.25f, 1.0f));
+		}
+		return rowMajor.pixels.back().r;
+	};
+
+	BENCHMARK("1024x1024 WritePixel, tiled")
+	{
+		for (uint32_t y = 0; y < tiled.height; ++y)
+		{
+			for (uint32_t x = 0; x < tiled.width; ++x)
+				tiled.WritePixel(x, y, Color(0.5f, 0.25f, 1.0f));
+		}
+		return tiled.pixels.back().r;
+	};
+}
+
+TEST_CASE( "Canvas encoding", "[canvas][benchmark]" )
+{
+	Canvas canvas(512, 512);
+	for (uint32_t y = 0; y < canvas.height; ++y)
+	{
+		for (uint32_t x = 0; x < canvas.width; ++x)
+			canvas.WritePixel(x, y, Color(x / 512.0f, y / 512.0f, 0.5f));
+	}
+
+	REQUIRE(canvas.ToPpm() == ToPpmWithStringStream(canvas));
+
+	BENCHMARK("512x512 pixels as P3 through a stringstream")
+	{
+		return ToPpmWithStringStream(canvas).size();
+	};
+
+	BENCHMARK("512x512 pixels as P3 with ToPpm")
+	{
+		return canvas.ToPpm().size();
+	};
+
+	BENCHMARK("512x512 pixels as P6 into a stream")
+	{
+		std::ostringstream stream;
+		canvas.WriteBinaryPpm(stream);
+		return stream.tellp();
+	};
+
+	Canvas frame(1920, 1080);
+	frame.Fill(Color(0.25f, 0.5f, 1.0f));
+
+	BENCHMARK("1920x1080 pixels as P3 with ToPpm")
+	{
+		return frame.ToPpm().size();
+	};
+
+	BENCHMARK("1920x1080 pixels as P3 on all threads")
+	{
+		return frame.ToPpm(0).size();
+	};
+
+	BENCHMARK("1920x1080 pixels as P6 into a stream")
+	{
+		std::ostringstream stream;
+		frame.WriteBinaryPpm(stream);
+		return stream.tellp();
+	};
+
+	BENCHMARK("1920x1080 pixels as P6 on all threads")
+	{
+		std::ostringstream stream;
+		frame.WriteBinaryPpm(stream, 0);
+		return stream.tellp();
+	};
+}
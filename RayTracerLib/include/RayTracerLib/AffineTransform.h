@@ -0,0 +1,281 @@
+#ifndef AFFINE_TRANSFORM_H_
+#define AFFINE_TRANSFORM_H_
+
+#include <array>
+#include <cassert>
+#include <string>
+#include <type_traits>
+
+#include "Matrix.h"
+#include "RayMath.h"
+#include "Tuple.h"
+#include "TupleTypes.h"
+
+// A 4x4 transform whose bottom row is always 0 0 0 1, stored as its top three rows: the upper 3x3 linear part and the
+// translation in the last column. Composing two of them or inverting one skips all the work on the constant row.
+template <typename T = float>
+class AffineTransformT
+{
+public:
+	static_assert(std::is_floating_point_v<T>);
+	using Scalar = T;
+	using RowType = std::array<T, 4>;
+	using ElementsType = std::array<RowType, 3>;
+
+	explicit AffineTransformT(const ElementsType& elements) : m_elements(elements)
+	{
+	}
+
+	// The bottom row of the matrix is expected to be 0 0 0 1 and is dropped.
+	explicit AffineTransformT(const Matrix<4, T>& matrix)
+	{
+		assert(Equal(matrix.m_elements[3][0], T(0)) && Equal(matrix.m_elements[3][1], T(0))
+			&& Equal(matrix.m_elements[3][2], T(0)) && Equal(matrix.m_elements[3][3], T(1)));
+
+		for (size_t row = 0; row < 3; ++row)
+			m_elements[row] = matrix.m_elements[row];
+	}
+
+	[[nodiscard]] Matrix<4, T> ToMatrix() const;
+	[[nodiscard]] AffineTransformT Inverse() const;
+	[[nodiscard]] T Determinant() const;
+	[[nodiscard]] bool IsInvertible() const;
+
+	[[nodiscard]] static AffineTransformT Identity();
+
+	ElementsType m_elements;
+};
+
+using AffineTransform = AffineTransformT<float>;
+using AffineTransformd = AffineTransformT<double>;
+
+static_assert(sizeof(AffineTransform) == 3 * sizeof(Matrix4x4) / 4, "AffineTransform must stay three rows of four floats");
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+Matrix<4, T> AffineTransformT<T>::ToMatrix() const
+{
+	return Matrix<4, T>(typename Matrix<4, T>::MatrixElementsType{
+		m_elements[0],
+		m_elements[1],
+		m_elements[2],
+		typename Matrix<4, T>::MatrixRowType{T(0), T(0), T(0), T(1)}
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+T AffineTransformT<T>::Determinant() const
+{
+	const auto& m = m_elements;
+	return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool AffineTransformT<T>::IsInvertible() const
+{
+	return !Equal(Determinant(), T(0));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The inverse of [L | t] is [L^-1 | -L^-1 t], with L^-1 the adjugate of the 3x3 part over its determinant.
+template <typename T>
+AffineTransformT<T> AffineTransformT<T>::Inverse() const
+{
+	const auto& m = m_elements;
+
+	const T c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+	const T c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+	const T c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+	const T determinant = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+	assert(!Equal(determinant, T(0)));
+	const T inverseDeterminant = T(1) / determinant;
+
+	ElementsType inverse;
+	inverse[0][0] = c00 * inverseDeterminant;
+	inverse[1][0] = c01 * inverseDeterminant;
+	inverse[2][0] = c02 * inverseDeterminant;
+	inverse[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inverseDeterminant;
+	inverse[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inverseDeterminant;
+	inverse[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inverseDeterminant;
+	inverse[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inverseDeterminant;
+	inverse[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inverseDeterminant;
+	inverse[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inverseDeterminant;
+
+	for (size_t row = 0; row < 3; ++row)
+	{
+		inverse[row][3] = -(inverse[row][0] * m[0][3] + inverse[row][1] * m[1][3] + inverse[row][2] * m[2][3]);
+	}
+
+	return AffineTransformT(inverse);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+AffineTransformT<T> AffineTransformT<T>::Identity()
+{
+	return AffineTransformT(ElementsType{{
+		{T(1), T(0), T(0), T(0)},
+		{T(0), T(1), T(0), T(0)},
+		{T(0), T(0), T(1), T(0)},
+	}});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool operator==(const AffineTransformT<T>& lhs, const AffineTransformT<T>& rhs)
+{
+	for (size_t row = 0; row < 3; ++row)
+	{
+		for (size_t col = 0; col < 4; ++col)
+		{
+			if (!Equal(lhs.m_elements[row][col], rhs.m_elements[row][col]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+bool operator!=(const AffineTransformT<T>& lhs, const AffineTransformT<T>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(RAYTRACER_SSE)
+
+// Same row broadcast scheme as MultiplySse with three rows, the implicit 0 0 0 1 row of rhs only adds the lhs
+// translation.
+inline AffineTransform MultiplySse(const AffineTransform& lhs, const AffineTransform& rhs)
+{
+	const auto& a = lhs.m_elements;
+	const __m128 rhsRow0 = _mm_loadu_ps(rhs.m_elements[0].data());
+	const __m128 rhsRow1 = _mm_loadu_ps(rhs.m_elements[1].data());
+	const __m128 rhsRow2 = _mm_loadu_ps(rhs.m_elements[2].data());
+
+	AffineTransform::ElementsType result;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		__m128 row = _mm_setr_ps(0.0f, 0.0f, 0.0f, a[i][3]);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][0]), rhsRow0));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][1]), rhsRow1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][2]), rhsRow2));
+		_mm_storeu_ps(result[i].data(), row);
+	}
+
+	return AffineTransform(result);
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// [La | ta] * [Lb | tb] = [La Lb | La tb + ta], 36 multiplies against 64 for the full 4x4 product.
+template <typename T>
+AffineTransformT<T> operator*(const AffineTransformT<T>& lhs, const AffineTransformT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+		return MultiplySse(lhs, rhs);
+#endif
+
+	const auto& a = lhs.m_elements;
+	const auto& b = rhs.m_elements;
+
+	typename AffineTransformT<T>::ElementsType result;
+	for (size_t row = 0; row < 3; ++row)
+	{
+		for (size_t col = 0; col < 4; ++col)
+		{
+			result[row][col] = a[row][0] * b[0][col] + a[row][1] * b[1][col] + a[row][2] * b[2][col];
+		}
+		result[row][3] += a[row][3];
+	}
+
+	return AffineTransformT<T>(result);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+TupleT<T> operator*(const AffineTransformT<T>& lhs, const TupleT<T>& rhs)
+{
+	const auto& m = lhs.m_elements;
+	return {
+		rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2] + rhs.w * m[0][3],
+		rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2] + rhs.w * m[1][3],
+		rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2] + rhs.w * m[2][3],
+		rhs.w
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Point3 operator*(const AffineTransform& lhs, const Point3& rhs)
+{
+	const auto& m = lhs.m_elements;
+	return {
+		rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2] + m[0][3],
+		rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2] + m[1][3],
+		rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2] + m[2][3]
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Vector3 operator*(const AffineTransform& lhs, const Vector3& rhs)
+{
+	const auto& m = lhs.m_elements;
+	return {
+		rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2],
+		rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2],
+		rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2]
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Expects the inverse transpose of the object transform, like the Matrix4x4 overload.
+inline Normal3 operator*(const AffineTransform& lhs, const Normal3& rhs)
+{
+	return Normal3(lhs * rhs.ToVector());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Transforms a normal with the inverse of the object transform, reading its 3x3 part transposed so the inverse
+// transpose never has to be built. The translation does not apply to normals.
+inline Normal3 TransformNormal(const AffineTransform& inverse, const Normal3& normal)
+{
+	const auto& m = inverse.m_elements;
+	return {
+		normal.x * m[0][0] + normal.y * m[1][0] + normal.z * m[2][0],
+		normal.x * m[0][1] + normal.y * m[1][1] + normal.z * m[2][1],
+		normal.x * m[0][2] + normal.y * m[1][2] + normal.z * m[2][2]
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+std::string ToString(const AffineTransformT<T>& transform)
+{
+	return ToString(transform.ToMatrix());
+}
+
+#endif // !AFFINE_TRANSFORM_H_
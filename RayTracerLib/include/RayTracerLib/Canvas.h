@@ -1,29 +1,206 @@
 #ifndef CANVAS_H_
 #define CANVAS_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <iosfwd>
+#include <iterator>
+#include <new>
+#include <string>
 #include <vector>
 
 #include "Color.h"
 
-constexpr uint32_t TwoDimensionToOne(const uint32_t width, const uint32_t x, const uint32_t y)
+// 64-bit so images over 4 billion pixels do not wrap around.
+constexpr uint64_t TwoDimensionToOne(const uint32_t width, const uint32_t x, const uint32_t y)
 {
-	return width * y + x;
+	return static_cast<uint64_t>(width) * y + x;
 }
 
+enum class CanvasLayout
+{
+	RowMajor,
+	// CANVAS_TILE_SIZE x CANVAS_TILE_SIZE blocks stored one after another, each block row-major. Pixels that are close
+	// in 2D are close in memory, and since the pixels start on a cache line and a tile is a whole number of lines,
+	// threads working on different tiles never write the same cache line.
+	Tiled,
+};
+
+constexpr uint32_t CANVAS_TILE_SIZE = 8;
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+static_assert(CANVAS_TILE_SIZE * CANVAS_TILE_SIZE * sizeof(Color) % CACHE_LINE_SIZE == 0,
+	"A tile must cover whole cache lines");
+
+// Allocates on cache line boundaries, std::allocator only guarantees the alignment of the type.
+template <typename T>
+struct CacheAlignedAllocator
+{
+	using value_type = T;
+
+	CacheAlignedAllocator() = default;
+	template <typename U>
+	constexpr CacheAlignedAllocator(const CacheAlignedAllocator<U>&) noexcept {}
+
+	[[ nodiscard ]] T* allocate(const size_t count)
+	{
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+	}
+
+	void deallocate(T* pointer, size_t) noexcept
+	{
+		::operator delete(pointer, std::align_val_t(CACHE_LINE_SIZE));
+	}
+};
+
+template <typename T, typename U>
+constexpr bool operator==(const CacheAlignedAllocator<T>&, const CacheAlignedAllocator<U>&) { return true; }
+template <typename T, typename U>
+constexpr bool operator!=(const CacheAlignedAllocator<T>&, const CacheAlignedAllocator<U>&) { return false; }
+
+// One tile of a canvas, clipped at the right and bottom edges. (x, y) is the top left pixel on the canvas.
+template <typename PixelT>
+struct CanvasTileT
+{
+	[[ nodiscard ]] PixelT& At(const uint32_t localX, const uint32_t localY) const
+	{
+		return first[localY * stride + localX];
+	}
+
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	PixelT* first;
+	// Distance between the starts of two tile rows in pixels.
+	size_t stride;
+};
+
+using CanvasTile = CanvasTileT<Color>;
+using ConstCanvasTile = CanvasTileT<const Color>;
+
+template <typename CanvasT, typename TileT>
+class CanvasTileIterator
+{
+public:
+	// Tiles are views made on the fly, so dereferencing yields a value and this is only an input iterator.
+	using iterator_category = std::input_iterator_tag;
+	using value_type = TileT;
+	using difference_type = std::ptrdiff_t;
+	using pointer = void;
+	using reference = TileT;
+
+	CanvasTileIterator(CanvasT* canvas, const size_t index) : m_canvas(canvas), m_index(index) {}
+
+	TileT operator*() const { return m_canvas->Tile(m_index); }
+	CanvasTileIterator& operator++() { ++m_index; return *this; }
+	CanvasTileIterator operator++(int) { auto copy = *this; ++m_index; return copy; }
+	bool operator==(const CanvasTileIterator& rhs) const { return m_index == rhs.m_index; }
+	bool operator!=(const CanvasTileIterator& rhs) const { return m_index != rhs.m_index; }
+
+private:
+	CanvasT* m_canvas;
+	size_t m_index;
+};
+
+template <typename CanvasT, typename TileT>
+struct CanvasTileRange
+{
+	[[ nodiscard ]] CanvasTileIterator<CanvasT, TileT> begin() const { return {canvas, 0}; }
+	[[ nodiscard ]] CanvasTileIterator<CanvasT, TileT> end() const { return {canvas, canvas->TileCount()}; }
+
+	CanvasT* canvas;
+};
+
 struct Canvas
 {
-	Canvas(const uint32_t w, const uint32_t h);
+	Canvas(const uint32_t w, const uint32_t h, CanvasLayout layout = CanvasLayout::RowMajor);
 
+	[[ nodiscard ]] size_t PixelIndex(uint32_t x, uint32_t y) const;
 	void WritePixel(uint32_t x, uint32_t y, const Color& color);
 	[[ nodiscard ]] Color PixelAt(uint32_t x, uint32_t y) const;
 	void Fill(const Color& color);
-	[[ nodiscard ]] std::string ToPpm() const;
+	// `threadCount` above 1 (0 for one per hardware thread) encodes bands of rows in parallel into separate buffers
+	// that are joined in order, the output is the same for any thread count.
+	[[ nodiscard ]] std::string ToPpm(size_t threadCount = 1) const;
+	// Binary P6 image, quantized with ColorFloatToUint8 into a fixed buffer that is flushed as it fills up. With more
+	// than one thread every band gets a buffer of its own, so the whole image is held in memory once more.
+	// Throws std::runtime_error if a write fails.
+	void WriteBinaryPpm(std::ostream& stream, size_t threadCount = 1) const;
+	void WriteBinaryPpm(std::FILE* file, size_t threadCount = 1) const;
+	// Copies row `y` to `out`, which has room for `width` pixels.
+	void ReadRow(uint32_t y, Color* out) const;
+
+	// Tiles are numbered row by row, whatever the layout.
+	[[ nodiscard ]] size_t TileCount() const;
+	[[ nodiscard ]] CanvasTile Tile(size_t index);
+	[[ nodiscard ]] ConstCanvasTile Tile(size_t index) const;
+	[[ nodiscard ]] CanvasTileRange<Canvas, CanvasTile> Tiles() { return {this}; }
+	[[ nodiscard ]] CanvasTileRange<const Canvas, ConstCanvasTile> Tiles() const { return {this}; }
 	
 	uint32_t width;
 	uint32_t height;
+	CanvasLayout layout;
+
+	// Padded to whole tiles in the tiled layout.
+	std::vector<Color, CacheAlignedAllocator<Color>> pixels;
 
-	std::vector<Color> pixels;
+private:
+	[[ nodiscard ]] uint32_t TilesPerRow() const { return (width + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE; }
+	[[ nodiscard ]] uint32_t TilesPerColumn() const { return (height + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE; }
+	template <typename TileT, typename CanvasT>
+	static TileT MakeTile(CanvasT& canvas, size_t index);
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+
+inline size_t Canvas::PixelIndex(const uint32_t x, const uint32_t y) const
+{
+	if (layout == CanvasLayout::RowMajor)
+		return static_cast<size_t>(TwoDimensionToOne(width, x, y));
+
+	const size_t tile = static_cast<size_t>(y / CANVAS_TILE_SIZE) * TilesPerRow() + x / CANVAS_TILE_SIZE;
+	return tile * CANVAS_TILE_SIZE * CANVAS_TILE_SIZE + (y % CANVAS_TILE_SIZE) * CANVAS_TILE_SIZE + x % CANVAS_TILE_SIZE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline size_t Canvas::TileCount() const
+{
+	return static_cast<size_t>(TilesPerRow()) * TilesPerColumn();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename TileT, typename CanvasT>
+TileT Canvas::MakeTile(CanvasT& canvas, const size_t index)
+{
+	const auto tilesPerRow = canvas.TilesPerRow();
+	const auto x = static_cast<uint32_t>(index % tilesPerRow) * CANVAS_TILE_SIZE;
+	const auto y = static_cast<uint32_t>(index / tilesPerRow) * CANVAS_TILE_SIZE;
+	const size_t stride = canvas.layout == CanvasLayout::Tiled ? CANVAS_TILE_SIZE : canvas.width;
+
+	return {x, y, std::min(CANVAS_TILE_SIZE, canvas.width - x), std::min(CANVAS_TILE_SIZE, canvas.height - y),
+		canvas.pixels.data() + canvas.PixelIndex(x, y), stride};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline CanvasTile Canvas::Tile(const size_t index)
+{
+	return MakeTile<CanvasTile>(*this, index);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline ConstCanvasTile Canvas::Tile(const size_t index) const
+{
+	return MakeTile<ConstCanvasTile>(*this, index);
+}
+
+// Number of pixels that are not Equal between two canvases of the same size.
+[[ nodiscard ]] size_t CountDifferentPixels(const Canvas& lhs, const Canvas& rhs);
+
 #endif // !CANVAS_H_
\ No newline at end of file
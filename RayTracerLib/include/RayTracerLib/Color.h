@@ -5,6 +5,9 @@
 #include <cstdint>
 #include <algorithm>
 #include <cmath>
+#include <type_traits>
+
+#include "RayMath.h"
 
 constexpr uint8_t MINIMUM_COLOR_VALUE = 0;
 constexpr uint8_t MAXIMUM_COLOR_VALUE = 255;
@@ -20,27 +23,146 @@ constexpr uint8_t ColorUint8ToFloat(const uint8_t color)
 	return static_cast<float>(color) / static_cast<float>(MAXIMUM_COLOR_VALUE);
 }
 
-struct Color
+// Channels are float by default; ColorT<double> is there for accumulating many samples without losing precision.
+template <typename T>
+struct ColorT
 {
-	Color() = default;
-	Color(const float red, const float green, const float blue) : r(red), g(green), b(blue) {}
+	static_assert(std::is_floating_point_v<T>);
+	using Scalar = T;
 
-	Color operator+(const Color& rhs) const;
-	Color operator-(const Color& rhs) const;
-	Color operator*(const Color& rhs) const;
+	ColorT() = default;
+	constexpr ColorT(const T red, const T green, const T blue) : r(red), g(green), b(blue) {}
 
-	friend bool operator==(const Color& lhs, const Color& rhs);
-	friend bool operator!=(const Color& lhs, const Color& rhs);
+	constexpr ColorT operator+(const ColorT& rhs) const;
+	constexpr ColorT operator-(const ColorT& rhs) const;
+	constexpr ColorT operator*(const ColorT& rhs) const;
 
-	float r;
-	float g;
-	float b;
+	T r;
+	T g;
+	T b;
 };
 
-Color operator*(const Color& lhs, float rhs);
-Color operator*(float lhs, const Color& rhs);
+using Color = ColorT<float>;
+using Colord = ColorT<double>;
+
+static_assert(sizeof(Color) == 3 * sizeof(float), "Color arrays must be plain float triples");
+
+template <typename T>
+constexpr bool operator==(const ColorT<T>& lhs, const ColorT<T>& rhs);
+template <typename T>
+constexpr bool operator!=(const ColorT<T>& lhs, const ColorT<T>& rhs);
+template <typename T>
+constexpr ColorT<T> operator*(const ColorT<T>& lhs, typename ColorT<T>::Scalar rhs);
+template <typename T>
+constexpr ColorT<T> operator*(typename ColorT<T>::Scalar lhs, const ColorT<T>& rhs);
+
+template <typename T>
+[[ nodiscard ]] std::string ToString(const ColorT<T>& color);
+template <typename T>
+[[ nodiscard ]] constexpr ColorT<T> HadamardProduct(const ColorT<T>& lhs, const ColorT<T>& rhs);
+// Bit i is set when channel i (r, g, b) of lhs and rhs are Equal.
+template <typename T>
+[[ nodiscard ]] constexpr uint32_t EqualMask(const ColorT<T>& lhs, const ColorT<T>& rhs);
+// Number of colors that differ between two arrays of `count` colors, for diffing rendered images.
+[[ nodiscard ]] RAYTRACER_MATH_API size_t CountNotEqual(const Color* lhs, const Color* rhs, size_t count);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> operator*(const ColorT<T>& lhs, const typename ColorT<T>::Scalar rhs)
+{
+	return {lhs.r * rhs, lhs.g * rhs, lhs.b * rhs};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> operator*(const typename ColorT<T>::Scalar lhs, const ColorT<T>& rhs)
+{
+	return operator*(rhs, lhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> HadamardProduct(const ColorT<T>& lhs, const ColorT<T>& rhs)
+{
+	return {lhs.r * rhs.r, lhs.g * rhs.g, lhs.b * rhs.b};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> ColorT<T>::operator+(const ColorT& rhs) const
+{
+	return {r + rhs.r, g + rhs.g, b + rhs.b};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> ColorT<T>::operator-(const ColorT& rhs) const
+{
+	return {r - rhs.r, g - rhs.g, b - rhs.b};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr ColorT<T> ColorT<T>::operator*(const ColorT& rhs) const
+{
+	return HadamardProduct(*this, rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(RAYTRACER_SSE)
+
+inline uint32_t EqualMaskSse(const Color& lhs, const Color& rhs)
+{
+	const __m128 difference = _mm_sub_ps(_mm_setr_ps(lhs.r, lhs.g, lhs.b, 0.0f), _mm_setr_ps(rhs.r, rhs.g, rhs.b, 0.0f));
+	const __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), difference);
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(magnitude, _mm_set1_ps(EPSILON)))) & 0x7u;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr uint32_t EqualMask(const ColorT<T>& lhs, const ColorT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return EqualMaskSse(lhs, rhs);
+	}
+#endif
+
+	return static_cast<uint32_t>(Equal(lhs.r, rhs.r))
+		| static_cast<uint32_t>(Equal(lhs.g, rhs.g)) << 1
+		| static_cast<uint32_t>(Equal(lhs.b, rhs.b)) << 2;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool operator==(const ColorT<T>& lhs, const ColorT<T>& rhs)
+{
+	return EqualMask(lhs, rhs) == 0x7;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool operator!=(const ColorT<T>& lhs, const ColorT<T>& rhs)
+{
+	return !(lhs == rhs);
+}
 
-[[ nodiscard ]] std::string ToString(const Color& color);
-[[ nodiscard ]] Color HadamardProduct(const Color& lhs, const Color& rhs);
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "impl/ColorImpl.h"
+#endif
 
-#endif // !COLOR_H_ 
+#endif // !COLOR_H_
@@ -2,56 +2,71 @@
 #define MATRIX_H_
 
 #include <cstdint>
+#include <cmath>
 #include <cassert>
 #include <array>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
 
 #include "RayMath.h"
+#include "Tuple.h"
+#include "TupleTypes.h"
+#include "TuplePacket.h"
 
 
-template <size_t N>
+// Square matrix of N x N elements of type T. float is the default and the one used by the hot paths, the double
+// aliases are for building long transform chains or scene setup where the accumulated error matters.
+template <size_t N, typename T = float>
 class Matrix
 {
 public:
-	using MatrixRowType = std::array<float, N>;
+	static_assert(std::is_floating_point_v<T>);
+	using Scalar = T;
+	using MatrixRowType = std::array<T, N>;
 	using MatrixElementsType = std::array<MatrixRowType, N>;
 
-	explicit Matrix(const float elements[N][N])
+	constexpr explicit Matrix(const T elements[N][N]) : m_elements{}
 	{
-		for (uint32_t i = 0; i < N; ++i)
+		for (size_t i = 0; i < N; ++i)
 		{
-			for (uint32_t j = 0; j < N; ++j)
+			for (size_t j = 0; j < N; ++j)
 			{
 				m_elements[i][j] = elements[i][j];
 			}
 		}
 	}
 
-	explicit Matrix(const MatrixElementsType& elements) : m_elements(elements)
+	constexpr explicit Matrix(const MatrixElementsType& elements) : m_elements(elements)
 	{
 	}
 
-	inline MatrixRowType& operator[](uint32_t row) { return m_elements[row]; }
-	inline MatrixRowType operator[](uint32_t row) const { return m_elements[row]; }
+	// Rows are returned by reference, reading an element never copies its row.
+	constexpr MatrixRowType& operator[](size_t row) { return m_elements[row]; }
+	constexpr const MatrixRowType& operator[](size_t row) const { return m_elements[row]; }
+	constexpr T& operator()(size_t row, size_t col) { return m_elements[row][col]; }
+	constexpr const T& operator()(size_t row, size_t col) const { return m_elements[row][col]; }
+	// The N * N elements in row-major order, for kernels that load whole rows.
+	constexpr T* data() { return m_elements[0].data(); }
+	constexpr const T* data() const { return m_elements[0].data(); }
 
-	template <size_t M>
-	friend bool operator==(const Matrix<M>& lhs, const Matrix<M>& rhs);
+	template <size_t M, typename U>
+	friend constexpr bool operator==(const Matrix<M, U>& lhs, const Matrix<M, U>& rhs);
 
-	template <size_t M>
-	friend bool operator!=(const Matrix<M>& lhs, const Matrix<M>& rhs);
+	template <size_t M, typename U>
+	friend constexpr bool operator!=(const Matrix<M, U>& lhs, const Matrix<M, U>& rhs);
 
-	template <size_t M>
-	friend Matrix<M> operator*(const Matrix<M>& lhs, const Matrix<M>& rhs);
+	template <size_t M, typename U>
+	friend constexpr Matrix<M, U> operator*(const Matrix<M, U>& lhs, const Matrix<M, U>& rhs);
 
-	[[nodiscard]] constexpr size_t Width() { return N; }
-	[[nodiscard]] Matrix Transpose() const;
-	[[nodiscard]] constexpr Matrix<N-1> Submatrix(size_t row, size_t column) const;
+	[[nodiscard]] constexpr size_t Width() const { return N; }
+	[[nodiscard]] constexpr Matrix Transpose() const;
+	[[nodiscard]] constexpr Matrix<N-1, T> Submatrix(size_t row, size_t column) const;
 	[[nodiscard]] constexpr Matrix Inverse() const;
-	[[nodiscard]] constexpr float Determinant() const;
-	[[nodiscard]] constexpr float Minor(size_t row, size_t col) const;
-	[[nodiscard]] constexpr float Cofactor(size_t row, size_t col) const;
+	[[nodiscard]] constexpr T Determinant() const;
+	[[nodiscard]] constexpr T Minor(size_t row, size_t col) const;
+	[[nodiscard]] constexpr T Cofactor(size_t row, size_t col) const;
 	[[nodiscard]] constexpr bool IsInvertible() const;
 
 	[[nodiscard]] constexpr static size_t MatrixWidth() { return N; }
@@ -65,14 +80,19 @@ public:
 using Matrix4x4 = Matrix<4>;
 using Matrix3x3 = Matrix<3>;
 using Matrix2x2 = Matrix<2>;
+using Matrix4x4d = Matrix<4, double>;
+using Matrix3x3d = Matrix<3, double>;
+using Matrix2x2d = Matrix<2, double>;
+
+static_assert(sizeof(Matrix4x4) == 16 * sizeof(float), "Matrix rows must be contiguous for data()");
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-constexpr Matrix<N-1> Matrix<N>::Submatrix(size_t row, size_t column) const
+template <size_t N, typename T>
+constexpr Matrix<N-1, T> Matrix<N, T>::Submatrix(size_t row, size_t column) const
 {
 	static_assert(N >= 3);
-	float newMatrixEls[N-1][N-1];
+	T newMatrixEls[N-1][N-1] = {};
 
 	size_t newRow = 0;
 	for (size_t i = 0; i < N; ++i)
@@ -91,21 +111,286 @@ constexpr Matrix<N-1> Matrix<N>::Submatrix(size_t row, size_t column) const
 		newRow++;
 	}
 
-	return Matrix<N-1>(newMatrixEls);
+	return Matrix<N-1, T>(newMatrixEls);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-bool operator==(const Matrix<N>& lhs, const Matrix<N>& rhs)
+// The twelve 2x2 minors a 4x4 inverse and determinant are built from: s from the top two rows, c from the bottom two.
+template <typename T>
+struct Minors2x2
+{
+	constexpr explicit Minors2x2(const Matrix<4, T>& matrix)
+	{
+		const auto& a = matrix.m_elements;
+		s[0] = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+		s[1] = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+		s[2] = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+		s[3] = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+		s[4] = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+		s[5] = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+		c[0] = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+		c[1] = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+		c[2] = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+		c[3] = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+		c[4] = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+		c[5] = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+	}
+
+	[[nodiscard]] constexpr T Determinant() const
+	{
+		return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+	}
+
+	T s[6] = {};
+	T c[6] = {};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr Matrix<4, T> Inverse4x4(const Matrix<4, T>& matrix)
+{
+	const auto& a = matrix.m_elements;
+	const Minors2x2<T> minors(matrix);
+	const T* s = minors.s;
+	const T* c = minors.c;
+
+	const T determinant = minors.Determinant();
+	assert(!Equal(determinant, T(0)));
+	const T inverseDeterminant = T(1) / determinant;
+
+	typename Matrix<4, T>::MatrixElementsType b = {};
+	b[0][0] = ( a[1][1] * c[5] - a[1][2] * c[4] + a[1][3] * c[3]) * inverseDeterminant;
+	b[0][1] = (-a[0][1] * c[5] + a[0][2] * c[4] - a[0][3] * c[3]) * inverseDeterminant;
+	b[0][2] = ( a[3][1] * s[5] - a[3][2] * s[4] + a[3][3] * s[3]) * inverseDeterminant;
+	b[0][3] = (-a[2][1] * s[5] + a[2][2] * s[4] - a[2][3] * s[3]) * inverseDeterminant;
+
+	b[1][0] = (-a[1][0] * c[5] + a[1][2] * c[2] - a[1][3] * c[1]) * inverseDeterminant;
+	b[1][1] = ( a[0][0] * c[5] - a[0][2] * c[2] + a[0][3] * c[1]) * inverseDeterminant;
+	b[1][2] = (-a[3][0] * s[5] + a[3][2] * s[2] - a[3][3] * s[1]) * inverseDeterminant;
+	b[1][3] = ( a[2][0] * s[5] - a[2][2] * s[2] + a[2][3] * s[1]) * inverseDeterminant;
+
+	b[2][0] = ( a[1][0] * c[4] - a[1][1] * c[2] + a[1][3] * c[0]) * inverseDeterminant;
+	b[2][1] = (-a[0][0] * c[4] + a[0][1] * c[2] - a[0][3] * c[0]) * inverseDeterminant;
+	b[2][2] = ( a[3][0] * s[4] - a[3][1] * s[2] + a[3][3] * s[0]) * inverseDeterminant;
+	b[2][3] = (-a[2][0] * s[4] + a[2][1] * s[2] - a[2][3] * s[0]) * inverseDeterminant;
+
+	b[3][0] = (-a[1][0] * c[3] + a[1][1] * c[1] - a[1][2] * c[0]) * inverseDeterminant;
+	b[3][1] = ( a[0][0] * c[3] - a[0][1] * c[1] + a[0][2] * c[0]) * inverseDeterminant;
+	b[3][2] = (-a[3][0] * s[3] + a[3][1] * s[1] - a[3][2] * s[0]) * inverseDeterminant;
+	b[3][3] = ( a[2][0] * s[3] - a[2][1] * s[1] + a[2][2] * s[0]) * inverseDeterminant;
+
+	return Matrix<4, T>(b);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(RAYTRACER_SSE)
+
+// 2x2 matrices stored row-major in one register, (m00, m01, m10, m11).
+inline __m128 Mat2Mul(const __m128 lhs, const __m128 rhs)
+{
+	return _mm_add_ps(_mm_mul_ps(lhs, _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 3, 0))),
+		_mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// adjugate(lhs) * rhs
+inline __m128 Mat2AdjMul(const __m128 lhs, const __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(0, 0, 3, 3)), rhs),
+		_mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// lhs * adjugate(rhs)
+inline __m128 Mat2MulAdj(const __m128 lhs, const __m128 rhs)
+{
+	return _mm_sub_ps(_mm_mul_ps(lhs, _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(0, 3, 0, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// Blockwise inverse: the matrix is split into the 2x2 blocks A B / C D and the inverse is assembled from their
+// adjugates and determinants.
+inline Matrix4x4 InverseSse(const Matrix4x4& matrix)
+{
+	const float* m = matrix.data();
+	const __m128 row0 = _mm_loadu_ps(m);
+	const __m128 row1 = _mm_loadu_ps(m + 4);
+	const __m128 row2 = _mm_loadu_ps(m + 8);
+	const __m128 row3 = _mm_loadu_ps(m + 12);
+
+	const __m128 a = _mm_movelh_ps(row0, row1);
+	const __m128 b = _mm_movehl_ps(row1, row0);
+	const __m128 c = _mm_movelh_ps(row2, row3);
+	const __m128 d = _mm_movehl_ps(row3, row2);
+
+	// (|A|, |B|, |C|, |D|)
+	const __m128 blockDeterminants = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+	const __m128 determinantA = _mm_shuffle_ps(blockDeterminants, blockDeterminants, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 determinantB = _mm_shuffle_ps(blockDeterminants, blockDeterminants, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 determinantC = _mm_shuffle_ps(blockDeterminants, blockDeterminants, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 determinantD = _mm_shuffle_ps(blockDeterminants, blockDeterminants, _MM_SHUFFLE(3, 3, 3, 3));
+
+	const __m128 adjDC = Mat2AdjMul(d, c);
+	const __m128 adjAB = Mat2AdjMul(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(determinantD, a), Mat2Mul(b, adjDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(determinantA, d), Mat2Mul(c, adjAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(determinantB, c), Mat2MulAdj(d, adjAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(determinantC, b), Mat2MulAdj(a, adjDC));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+	const __m128 trace = HorizontalSum(_mm_mul_ps(adjAB, _mm_shuffle_ps(adjDC, adjDC, _MM_SHUFFLE(3, 1, 2, 0))));
+	const __m128 determinant = _mm_sub_ps(
+		_mm_add_ps(_mm_mul_ps(determinantA, determinantD), _mm_mul_ps(determinantB, determinantC)), trace);
+	assert(!Equal(_mm_cvtss_f32(determinant), 0.0f));
+
+	const __m128 inverseDeterminant = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+	x = _mm_mul_ps(x, inverseDeterminant);
+	y = _mm_mul_ps(y, inverseDeterminant);
+	z = _mm_mul_ps(z, inverseDeterminant);
+	w = _mm_mul_ps(w, inverseDeterminant);
+
+	Matrix4x4::MatrixElementsType elements;
+	_mm_storeu_ps(elements[0].data(), _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(elements[1].data(), _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(elements[2].data(), _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(elements[3].data(), _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+
+	return Matrix4x4(elements);
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Gauss-Jordan elimination with partial pivoting, reducing the matrix to the identity while applying the same row
+// operations to an identity matrix.
+template <size_t N, typename T>
+constexpr Matrix<N, T> InverseGaussJordan(const Matrix<N, T>& matrix)
+{
+	auto reduced = matrix.m_elements;
+	auto inverse = Matrix<N, T>::Identity().m_elements;
+
+	for (size_t col = 0; col < N; ++col)
+	{
+		size_t pivot = col;
+		for (size_t row = col + 1; row < N; ++row)
+		{
+			if (Abs(reduced[row][col]) > Abs(reduced[pivot][col]))
+				pivot = row;
+		}
+		assert(!Equal(reduced[pivot][col], T(0)));
+
+		if (pivot != col)
+		{
+			for (size_t j = 0; j < N; ++j)
+			{
+				const T reducedValue = reduced[col][j];
+				reduced[col][j] = reduced[pivot][j];
+				reduced[pivot][j] = reducedValue;
+
+				const T inverseValue = inverse[col][j];
+				inverse[col][j] = inverse[pivot][j];
+				inverse[pivot][j] = inverseValue;
+			}
+		}
+
+		const T scale = T(1) / reduced[col][col];
+		for (size_t j = 0; j < N; ++j)
+		{
+			reduced[col][j] *= scale;
+			inverse[col][j] *= scale;
+		}
+
+		for (size_t row = 0; row < N; ++row)
+		{
+			if (row == col)
+				continue;
+
+			const T factor = reduced[row][col];
+			for (size_t j = 0; j < N; ++j)
+			{
+				reduced[row][j] -= factor * reduced[col][j];
+				inverse[row][j] -= factor * inverse[col][j];
+			}
+		}
+	}
+
+	return Matrix<N, T>(inverse);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The same elimination as InverseGaussJordan reduced to upper triangular form. The determinant is the product of the
+// pivots, negated once per row swap; a column without a non-zero pivot means the matrix is singular.
+template <size_t N, typename T>
+constexpr T DeterminantGaussian(const Matrix<N, T>& matrix)
+{
+	auto reduced = matrix.m_elements;
+	T determinant = T(1);
+
+	for (size_t col = 0; col < N; ++col)
+	{
+		size_t pivot = col;
+		for (size_t row = col + 1; row < N; ++row)
+		{
+			if (Abs(reduced[row][col]) > Abs(reduced[pivot][col]))
+				pivot = row;
+		}
+
+		if (reduced[pivot][col] == T(0))
+			return T(0);
+
+		if (pivot != col)
+		{
+			for (size_t j = col; j < N; ++j)
+			{
+				const T value = reduced[col][j];
+				reduced[col][j] = reduced[pivot][j];
+				reduced[pivot][j] = value;
+			}
+			determinant = -determinant;
+		}
+
+		determinant *= reduced[col][col];
+
+		const T inversePivot = T(1) / reduced[col][col];
+		for (size_t row = col + 1; row < N; ++row)
+		{
+			const T factor = reduced[row][col] * inversePivot;
+			for (size_t j = col + 1; j < N; ++j)
+			{
+				reduced[row][j] -= factor * reduced[col][j];
+			}
+		}
+	}
+
+	return determinant;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N, typename T>
+constexpr bool operator==(const Matrix<N, T>& lhs, const Matrix<N, T>& rhs)
 {
 	for (uint32_t i = 0; i < N; ++i)
 	{
-		for (uint32_t j = 0; j < N; ++j)
+		if constexpr (N == 4 && std::is_same_v<T, float>)
 		{
-			if (!Equal(lhs[i][j], rhs[i][j]))
+			if (EqualMask4(lhs[i].data(), rhs[i].data()) != 0xF)
 				return false;
 		}
+		else
+		{
+			for (uint32_t j = 0; j < N; ++j)
+			{
+				if (!Equal(lhs(i, j), rhs(i, j)))
+					return false;
+			}
+		}
 	}
 
 	return true;
@@ -113,39 +398,101 @@ bool operator==(const Matrix<N>& lhs, const Matrix<N>& rhs)
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-bool operator!=(const Matrix<N>& lhs, const Matrix<N>& rhs)
+template <size_t N, typename T>
+constexpr bool operator!=(const Matrix<N, T>& lhs, const Matrix<N, T>& rhs)
 {
 	return !(lhs == rhs);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-Matrix<N> operator*(const Matrix<N>& lhs, const Matrix<N>& rhs)
+#if defined(RAYTRACER_SSE)
+
+// Each result row is the sum of the rhs rows weighted by the broadcast elements of the matching lhs row. With AVX two
+// result rows share one register, rhs rows are duplicated into both halves.
+inline void MultiplySse(const Matrix4x4& lhs, const Matrix4x4& rhs, Matrix4x4& result)
 {
-	float newMatrixEls[N][N];
-	for (uint32_t i = 0; i < N; ++i)
+	const auto& a = lhs.m_elements;
+	auto& out = result.m_elements;
+
+#if defined(RAYTRACER_AVX)
+	const __m256 rhsRow0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data()));
+	const __m256 rhsRow1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data() + 4));
+	const __m256 rhsRow2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data() + 8));
+	const __m256 rhsRow3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(rhs.data() + 12));
+
+	for (size_t i = 0; i < 4; i += 2)
 	{
-		for (uint32_t j = 0; j < N; ++j)
+		const __m256 lhsRows = _mm256_loadu_ps(a[i].data());
+		__m256 row = _mm256_mul_ps(_mm256_permute_ps(lhsRows, 0x00), rhsRow0);
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(lhsRows, 0x55), rhsRow1));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(lhsRows, 0xAA), rhsRow2));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(lhsRows, 0xFF), rhsRow3));
+		_mm256_storeu_ps(out[i].data(), row);
+	}
+#else
+	const __m128 rhsRow0 = _mm_loadu_ps(rhs.data());
+	const __m128 rhsRow1 = _mm_loadu_ps(rhs.data() + 4);
+	const __m128 rhsRow2 = _mm_loadu_ps(rhs.data() + 8);
+	const __m128 rhsRow3 = _mm_loadu_ps(rhs.data() + 12);
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		__m128 row = _mm_mul_ps(_mm_set1_ps(a[i][0]), rhsRow0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][1]), rhsRow1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][2]), rhsRow2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][3]), rhsRow3));
+		_mm_storeu_ps(out[i].data(), row);
+	}
+#endif
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The product is written straight into the returned matrix. The scalar loop runs in the same row broadcast order as
+// the SIMD kernel so the inner loop walks rows of both operands.
+template <size_t N, typename T>
+constexpr Matrix<N, T> operator*(const Matrix<N, T>& lhs, const Matrix<N, T>& rhs)
+{
+	Matrix<N, T> result(typename Matrix<N, T>::MatrixElementsType{});
+
+#if defined(RAYTRACER_SSE)
+	if constexpr (N == 4 && std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+		{
+			MultiplySse(lhs, rhs, result);
+			return result;
+		}
+	}
+#endif
+
+	const auto& a = lhs.m_elements;
+	const auto& b = rhs.m_elements;
+	auto& out = result.m_elements;
+	for (size_t i = 0; i < N; ++i)
+	{
+		for (size_t k = 0; k < N; ++k)
 		{
-			newMatrixEls[i][j] = 0;
-			for (int k = 0; k < N; ++k)
+			const T element = a[i][k];
+			for (size_t j = 0; j < N; ++j)
 			{
-				newMatrixEls[i][j] += lhs[i][k] * rhs[k][j];
+				out[i][j] += element * b[k][j];
 			}
 		}
 	}
 
-	return Matrix<N>(newMatrixEls);
+	return result;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-Matrix<N> Matrix<N>::Transpose() const
+template <size_t N, typename T>
+constexpr Matrix<N, T> Matrix<N, T>::Transpose() const
 {
-	float newMatrixEls[N][N];
+	T newMatrixEls[N][N] = {};
 	for (uint32_t i = 0; i < N; ++i)
 	{
 		for (uint32_t j = 0; j < N; ++j)
@@ -154,67 +501,104 @@ Matrix<N> Matrix<N>::Transpose() const
 		}
 	}
 
-	return Matrix<N>(newMatrixEls);
+	return Matrix<N, T>(newMatrixEls);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-constexpr Matrix<N> Matrix<N>::Identity()
+template <size_t N, typename T>
+constexpr Matrix<N, T> Matrix<N, T>::Identity()
 {
-	float newMatrixEls[N][N];
+	T newMatrixEls[N][N] = {};
 	for (uint32_t i = 0; i < N; ++i)
 	{
 		for (uint32_t j = 0; j < N; ++j)
 		{
-			const float val = (i == j) ? 1 : 0;
+			const T val = (i == j) ? 1 : 0;
 			newMatrixEls[i][j] = val;
 		}
 	}
 
-	return Matrix<N>(newMatrixEls);
+	return Matrix<N, T>(newMatrixEls);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-constexpr Matrix<N> Matrix<N>::Inverse() const
+// Cofactor expansion is cheap for the small sizes but grows factorially, so 4x4 uses the closed form over 2x2 minors
+// and larger matrices are reduced with Gauss-Jordan elimination, as in Determinant. The determinant is computed once, the asserts reuse
+// it instead of calling IsInvertible.
+template <size_t N, typename T>
+constexpr Matrix<N, T> Matrix<N, T>::Inverse() const
 {
-	assert(IsInvertible());
-
-	Matrix<N>::MatrixElementsType elements = {};
-	const auto determinant = Determinant();
-	for (size_t row = 0; row < N; ++row)
+	if constexpr (N == 4)
 	{
-		for (size_t col = 0; col < N; ++col)
+#if defined(RAYTRACER_SSE)
+		if constexpr (std::is_same_v<T, float>)
 		{
-			const auto cofactor = Cofactor(row, col);
-			elements[col][row] = cofactor / determinant;
+			if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+				return InverseSse(*this);
 		}
+#endif
+
+		return Inverse4x4(*this);
 	}
+	else if constexpr (N > 4)
+	{
+		return InverseGaussJordan(*this);
+	}
+	else
+	{
+		const auto determinant = Determinant();
+		assert(!Equal(determinant, T(0)));
+
+		typename Matrix<N, T>::MatrixElementsType elements = {};
+		for (size_t row = 0; row < N; ++row)
+		{
+			for (size_t col = 0; col < N; ++col)
+			{
+				const auto cofactor = Cofactor(row, col);
+				elements[col][row] = cofactor / determinant;
+			}
+		}
 
-	return Matrix<N>(elements);
+		return Matrix<N, T>(elements);
+	}
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-constexpr float Matrix<N>::Determinant() const
+template <size_t N, typename T>
+constexpr T Matrix<N, T>::Determinant() const
 {
-	static_assert(N > 2);
-	float result = 0.0f;
-	for (size_t i = 0; i < N; ++i)
+	static_assert(N >= 2);
+	if constexpr (N == 2)
 	{
-		result += m_elements[0][i] * Cofactor(0, i);
+		return m_elements[0][0] * m_elements[1][1] - m_elements[0][1] * m_elements[1][0];
+	}
+	else if constexpr (N == 4)
+	{
+		return Minors2x2(*this).Determinant();
+	}
+	else if constexpr (N > 4)
+	{
+		return DeterminantGaussian(*this);
+	}
+	else
+	{
+		T result = 0;
+		for (size_t i = 0; i < N; ++i)
+		{
+			result += m_elements[0][i] * Cofactor(0, i);
+		}
+
+		return result;
 	}
-	
-	return result;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-constexpr float Matrix<N>::Minor(size_t row, size_t col) const
+template <size_t N, typename T>
+constexpr T Matrix<N, T>::Minor(size_t row, size_t col) const
 {
 	static_assert(N > 2);
 	return Submatrix(row, col).Determinant();
@@ -222,8 +606,8 @@ constexpr float Matrix<N>::Minor(size_t row, size_t col) const
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-constexpr float Matrix<N>::Cofactor(size_t row, size_t col) const
+template <size_t N, typename T>
+constexpr T Matrix<N, T>::Cofactor(size_t row, size_t col) const
 {
 	static_assert(N > 2);
 	assert(row < N);
@@ -238,29 +622,21 @@ constexpr float Matrix<N>::Cofactor(size_t row, size_t col) const
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template<size_t N>
-inline constexpr bool Matrix<N>::IsInvertible() const
-{
-	return !Equal(Determinant(), 0.0f);
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-
-template<>
-constexpr float Matrix<2>::Determinant() const
+template <size_t N, typename T>
+inline constexpr bool Matrix<N, T>::IsInvertible() const
 {
-	return m_elements[0][0] * m_elements[1][1] - m_elements[0][1] * m_elements[1][0];
+	return !Equal(Determinant(), T(0));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <size_t N>
-std::string ToString(const Matrix<N>& matrix)
+template <size_t N, typename T>
+std::string ToString(const Matrix<N, T>& matrix)
 {
 	std::stringstream ss;
 	ss << std::fixed << std::setprecision(2);
 
-	const auto numberLength = [](float number) {
+	const auto numberLength = [](T number) {
 		size_t len = 0;
 		if (number < 0)
 		{
@@ -293,7 +669,7 @@ std::string ToString(const Matrix<N>& matrix)
 		std::string line;
 		for (uint32_t j = 0; j < N; ++j)
 		{
-			const auto matrixVal = matrix[i][j];
+			const auto matrixVal = matrix(i, j);
 			const auto matrixValLen = numberLength(matrixVal);
 			if (matrixValLen > widestNumberLen)
 				widestNumberLen = matrixValLen;
@@ -304,7 +680,7 @@ std::string ToString(const Matrix<N>& matrix)
 	{
 		for (uint32_t j = 0; j < N; ++j)
 		{
-			const auto matrixVal = matrix[i][j];
+			const auto matrixVal = matrix(i, j);
 			const auto matrixValLen = numberLength(matrixVal);
 			const std::string padding(widestNumberLen - matrixValLen, ' ');
 			ss << '|' << padding << matrixVal;
@@ -319,22 +695,24 @@ std::string ToString(const Matrix<N>& matrix)
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Matrix2x2 Make2x2Matrix(const std::array<float, Matrix2x2::MatrixWidth()*Matrix2x2::MatrixWidth()>& elements)
+template <typename T = float>
+constexpr Matrix<2, T> Make2x2Matrix(const std::array<T, 4>& elements)
 {
-	Matrix2x2::MatrixElementsType matrixElements;
+	typename Matrix<2, T>::MatrixElementsType matrixElements = {};
 	matrixElements[0][0] = elements[0];
 	matrixElements[0][1] = elements[1];
 	matrixElements[1][0] = elements[2];
 	matrixElements[1][1] = elements[3];
 
-	return Matrix2x2(matrixElements); 
+	return Matrix<2, T>(matrixElements);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Matrix3x3 Make3x3Matrix(const std::array<float, Matrix3x3::MatrixWidth()*Matrix3x3::MatrixWidth()>& elements)
+template <typename T = float>
+constexpr Matrix<3, T> Make3x3Matrix(const std::array<T, 9>& elements)
 {
-	Matrix3x3::MatrixElementsType matrixElements;
+	typename Matrix<3, T>::MatrixElementsType matrixElements = {};
 	matrixElements[0][0] = elements[0];
 	matrixElements[0][1] = elements[1];
 	matrixElements[0][2] = elements[2];
@@ -348,14 +726,15 @@ Matrix3x3 Make3x3Matrix(const std::array<float, Matrix3x3::MatrixWidth()*Matrix3
 	matrixElements[2][1] = elements[7];
 	matrixElements[2][2] = elements[8];
 
-	return Matrix3x3(matrixElements); 
+	return Matrix<3, T>(matrixElements);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Matrix4x4 Make4x4Matrix(const std::array<float, Matrix4x4::MatrixWidth()*Matrix4x4::MatrixWidth()>& elements)
+template <typename T = float>
+constexpr Matrix<4, T> Make4x4Matrix(const std::array<T, 16>& elements)
 {
-	Matrix4x4::MatrixElementsType matrixElements;
+	typename Matrix<4, T>::MatrixElementsType matrixElements = {};
 	matrixElements[0][0] = elements[0];
 	matrixElements[0][1] = elements[1];
 	matrixElements[0][2] = elements[2];
@@ -376,28 +755,274 @@ Matrix4x4 Make4x4Matrix(const std::array<float, Matrix4x4::MatrixWidth()*Matrix4
 	matrixElements[3][2] = elements[14];
 	matrixElements[3][3] = elements[15];
 
-	return Matrix4x4(matrixElements); 
+	return Matrix<4, T>(matrixElements);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Tuple operator*(const Matrix4x4& lhs, const Tuple& rhs)
+constexpr Matrix4x4 Translation(const float x, const float y, const float z)
 {
-	const float x = rhs.x * lhs[0][0] + rhs.y * lhs[0][1] + rhs.z * lhs[0][2] + rhs.w * lhs[0][3];
-	const float y = rhs.x * lhs[1][0] + rhs.y * lhs[1][1] + rhs.z * lhs[1][2] + rhs.w * lhs[1][3];
-	const float z = rhs.x * lhs[2][0] + rhs.y * lhs[2][1] + rhs.z * lhs[2][2] + rhs.w * lhs[2][3];
-	const float w = rhs.x * lhs[3][0] + rhs.y * lhs[3][1] + rhs.z * lhs[3][2] + rhs.w * lhs[3][3];
+	return Make4x4Matrix({
+		1.0f, 0.0f, 0.0f, x,
+		0.0f, 1.0f, 0.0f, y,
+		0.0f, 0.0f, 1.0f, z,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Matrix4x4 Scaling(const float x, const float y, const float z)
+{
+	return Make4x4Matrix({
+		x, 0.0f, 0.0f, 0.0f,
+		0.0f, y, 0.0f, 0.0f,
+		0.0f, 0.0f, z, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// std::cos and std::sin are not constexpr, constant evaluation goes through the series in ConstexprSinCos instead.
+constexpr Matrix4x4 RotationX(const float radians)
+{
+	const float cos = Cos(radians);
+	const float sin = Sin(radians);
+	return Make4x4Matrix({
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, cos, -sin, 0.0f,
+		0.0f, sin, cos, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Matrix4x4 RotationY(const float radians)
+{
+	const float cos = Cos(radians);
+	const float sin = Sin(radians);
+	return Make4x4Matrix({
+		cos, 0.0f, sin, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		-sin, 0.0f, cos, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Matrix4x4 RotationZ(const float radians)
+{
+	const float cos = Cos(radians);
+	const float sin = Sin(radians);
+	return Make4x4Matrix({
+		cos, -sin, 0.0f, 0.0f,
+		sin, cos, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Each component moves in proportion to another, xy is how much x moves in proportion to y and so on.
+constexpr Matrix4x4 Shearing(const float xy, const float xz, const float yx, const float yz, const float zx, const float zy)
+{
+	return Make4x4Matrix({
+		1.0f, xy, xz, 0.0f,
+		yx, 1.0f, yz, 0.0f,
+		zx, zy, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> operator*(const Matrix<4, T>& lhs, const TupleT<T>& rhs)
+{
+	const auto& m = lhs.m_elements;
+	const T x = rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2] + rhs.w * m[0][3];
+	const T y = rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2] + rhs.w * m[1][3];
+	const T z = rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2] + rhs.w * m[2][3];
+	const T w = rhs.x * m[3][0] + rhs.y * m[3][1] + rhs.z * m[3][2] + rhs.w * m[3][3];
 
 	return {x, y, z, w};
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Tuple operator*(const Tuple& lhs, const Matrix4x4& rhs)
+template <typename T>
+constexpr TupleT<T> operator*(const TupleT<T>& lhs, const Matrix<4, T>& rhs)
 {
 	return operator*(rhs, lhs);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+// The typed overloads are float only and treat the matrix as an affine transform: the bottom row is never read and w
+// is implied, so a point only picks up the translation column and a vector or normal only the upper 3x3.
+constexpr Point3 operator*(const Matrix4x4& lhs, const Point3& rhs)
+{
+	const auto& m = lhs.m_elements;
+	return {
+		rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2] + m[0][3],
+		rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2] + m[1][3],
+		rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2] + m[2][3]
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Vector3 operator*(const Matrix4x4& lhs, const Vector3& rhs)
+{
+	const auto& m = lhs.m_elements;
+	return {
+		rhs.x * m[0][0] + rhs.y * m[0][1] + rhs.z * m[0][2],
+		rhs.x * m[1][0] + rhs.y * m[1][1] + rhs.z * m[1][2],
+		rhs.x * m[2][0] + rhs.y * m[2][1] + rhs.z * m[2][2]
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Expects the inverse transpose of the object transform.
+constexpr Normal3 operator*(const Matrix4x4& lhs, const Normal3& rhs)
+{
+	return Normal3(lhs * rhs.ToVector());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Batched transforms. TransformPoints treats every input as a point (w = 1) and TransformVectors as a vector (w = 0)
+// whatever their stored w, so the result matches `matrix * tuple` for well formed tuples. The input and output
+// arrays may be the same array.
+void TransformPoints(const Matrix4x4& matrix, const Tuple* input, Tuple* output, size_t count);
+void TransformVectors(const Matrix4x4& matrix, const Tuple* input, Tuple* output, size_t count);
+// Structure-of-arrays versions over `count` packets, every lane of every packet is transformed.
+template <size_t W>
+void TransformPoints(const Matrix4x4& matrix, const TuplePacket<W>* input, TuplePacket<W>* output, size_t count);
+template <size_t W>
+void TransformVectors(const Matrix4x4& matrix, const TuplePacket<W>* input, TuplePacket<W>* output, size_t count);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The matrix columns stay in registers for the whole array. Each tuple is x * column0 + y * column1 + z * column2
+// + w * column3 with x, y and z broadcast from the loaded tuple, which needs no transposes.
+inline void TransformTuples(const Matrix4x4& matrix, const Tuple* input, Tuple* output, const size_t count, const float w)
+{
+	const auto& m = matrix.m_elements;
+	size_t i = 0;
+
+#if defined(RAYTRACER_AVX)
+	{
+		const __m256 column0 = _mm256_setr_ps(m[0][0], m[1][0], m[2][0], m[3][0], m[0][0], m[1][0], m[2][0], m[3][0]);
+		const __m256 column1 = _mm256_setr_ps(m[0][1], m[1][1], m[2][1], m[3][1], m[0][1], m[1][1], m[2][1], m[3][1]);
+		const __m256 column2 = _mm256_setr_ps(m[0][2], m[1][2], m[2][2], m[3][2], m[0][2], m[1][2], m[2][2], m[3][2]);
+		const __m256 column3 = _mm256_mul_ps(_mm256_set1_ps(w),
+			_mm256_setr_ps(m[0][3], m[1][3], m[2][3], m[3][3], m[0][3], m[1][3], m[2][3], m[3][3]));
+
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m256 tuples = _mm256_loadu_ps(&input[i].x);
+			__m256 result = _mm256_add_ps(column3, _mm256_mul_ps(column0, _mm256_permute_ps(tuples, 0x00)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(column1, _mm256_permute_ps(tuples, 0x55)));
+			result = _mm256_add_ps(result, _mm256_mul_ps(column2, _mm256_permute_ps(tuples, 0xAA)));
+			_mm256_storeu_ps(&output[i].x, result);
+		}
+	}
+#endif
+
+#if defined(RAYTRACER_SSE)
+	const __m128 column0 = _mm_setr_ps(m[0][0], m[1][0], m[2][0], m[3][0]);
+	const __m128 column1 = _mm_setr_ps(m[0][1], m[1][1], m[2][1], m[3][1]);
+	const __m128 column2 = _mm_setr_ps(m[0][2], m[1][2], m[2][2], m[3][2]);
+	const __m128 column3 = _mm_mul_ps(_mm_set1_ps(w), _mm_setr_ps(m[0][3], m[1][3], m[2][3], m[3][3]));
+
+	for (; i < count; ++i)
+	{
+		const __m128 tuple = LoadTuple(input[i]);
+		__m128 result = _mm_add_ps(column3, _mm_mul_ps(column0, _mm_shuffle_ps(tuple, tuple, 0x00)));
+		result = _mm_add_ps(result, _mm_mul_ps(column1, _mm_shuffle_ps(tuple, tuple, 0x55)));
+		result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_shuffle_ps(tuple, tuple, 0xAA)));
+		_mm_store_ps(&output[i].x, result);
+	}
+#else
+	for (; i < count; ++i)
+	{
+		const Tuple tuple = input[i];
+		output[i] = {
+			tuple.x * m[0][0] + tuple.y * m[0][1] + tuple.z * m[0][2] + w * m[0][3],
+			tuple.x * m[1][0] + tuple.y * m[1][1] + tuple.z * m[1][2] + w * m[1][3],
+			tuple.x * m[2][0] + tuple.y * m[2][1] + tuple.z * m[2][2] + w * m[2][3],
+			tuple.x * m[3][0] + tuple.y * m[3][1] + tuple.z * m[3][2] + w * m[3][3]
+		};
+	}
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void TransformPoints(const Matrix4x4& matrix, const Tuple* input, Tuple* output, const size_t count)
+{
+	TransformTuples(matrix, input, output, count, 1.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void TransformVectors(const Matrix4x4& matrix, const Tuple* input, Tuple* output, const size_t count)
+{
+	TransformTuples(matrix, input, output, count, 0.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Every matrix element is broadcast across a packet once, each packet is then 12 multiplies and adds per row.
+template <size_t W>
+void TransformTuples(const Matrix4x4& matrix, const TuplePacket<W>* input, TuplePacket<W>* output, const size_t count,
+	const float w)
+{
+	using Lanes = FloatLanes<W>;
+	const auto& m = matrix.m_elements;
+
+	Lanes rows[4][4];
+	for (size_t row = 0; row < 4; ++row)
+	{
+		for (size_t col = 0; col < 3; ++col)
+			rows[row][col] = Lanes::Broadcast(m[row][col]);
+		rows[row][3] = Lanes::Broadcast(m[row][3] * w);
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const TuplePacket<W> packet = input[i];
+		TuplePacket<W> result;
+		result.x = rows[0][0] * packet.x + rows[0][1] * packet.y + rows[0][2] * packet.z + rows[0][3];
+		result.y = rows[1][0] * packet.x + rows[1][1] * packet.y + rows[1][2] * packet.z + rows[1][3];
+		result.z = rows[2][0] * packet.x + rows[2][1] * packet.y + rows[2][2] * packet.z + rows[2][3];
+		result.w = rows[3][0] * packet.x + rows[3][1] * packet.y + rows[3][2] * packet.z + rows[3][3];
+		output[i] = result;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t W>
+void TransformPoints(const Matrix4x4& matrix, const TuplePacket<W>* input, TuplePacket<W>* output, const size_t count)
+{
+	TransformTuples(matrix, input, output, count, 1.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t W>
+void TransformVectors(const Matrix4x4& matrix, const TuplePacket<W>* input, TuplePacket<W>* output, const size_t count)
+{
+	TransformTuples(matrix, input, output, count, 0.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 #endif // !MATRIX_H_
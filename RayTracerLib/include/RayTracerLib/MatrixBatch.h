@@ -0,0 +1,17 @@
+#ifndef MATRIX_BATCH_H_
+#define MATRIX_BATCH_H_
+
+#include <cstddef>
+
+#include "Matrix.h"
+
+// Inverts or composes arrays of 4x4 matrices with the single matrix SIMD kernels, split across `threadCount` threads
+// (0 uses one per hardware thread). Transposing batches into structure-of-arrays form was measured slower than these
+// kernels, the win here is the threading. Every matrix must be invertible. The output array may be one of the input
+// arrays.
+void InvertMatrices(const Matrix4x4* input, Matrix4x4* output, size_t count, size_t threadCount = 1);
+// output[i] = lhs[i] * rhs[i]
+void ComposeMatrices(const Matrix4x4* lhs, const Matrix4x4* rhs, Matrix4x4* output, size_t count,
+	size_t threadCount = 1);
+
+#endif // !MATRIX_BATCH_H_
@@ -0,0 +1,88 @@
+#ifndef MATRIX_EXPRESSION_H_
+#define MATRIX_EXPRESSION_H_
+
+#include <type_traits>
+
+#include "Matrix.h"
+
+// Opt-in lazy products of matrices. Wrapping the operands in Lazy() makes `*` record the chain instead of computing
+// it, and nothing is evaluated until the chain meets a tuple or is converted to a Matrix:
+//
+//   const Tuple world = Lazy(parent) * Lazy(child) * Lazy(local) * point;
+//
+// applies local, then child, then parent to the point, three 4x4 * tuple products (48 multiplies) instead of two
+// 4x4 products and a 4x4 * tuple (144). Expressions hold pointers to the wrapped matrices, which must outlive them.
+
+struct MatrixExpressionTag {};
+
+template <typename E>
+constexpr bool IS_MATRIX_EXPRESSION = std::is_base_of_v<MatrixExpressionTag, E>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N, typename T>
+class LazyMatrix : public MatrixExpressionTag
+{
+public:
+	using MatrixType = Matrix<N, T>;
+
+	constexpr explicit LazyMatrix(const MatrixType& matrix) : m_matrix(&matrix) {}
+
+	template <typename V>
+	[[nodiscard]] constexpr V Apply(const V& value) const { return *m_matrix * value; }
+	[[nodiscard]] constexpr MatrixType Evaluate() const { return *m_matrix; }
+	constexpr operator MatrixType() const { return Evaluate(); }
+
+private:
+	const MatrixType* m_matrix;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename Lhs, typename Rhs>
+class MatrixProduct : public MatrixExpressionTag
+{
+public:
+	static_assert(std::is_same_v<typename Lhs::MatrixType, typename Rhs::MatrixType>);
+	using MatrixType = typename Lhs::MatrixType;
+
+	constexpr MatrixProduct(const Lhs& lhs, const Rhs& rhs) : m_lhs(lhs), m_rhs(rhs) {}
+
+	// Right to left, each step is a matrix * value product.
+	template <typename V>
+	[[nodiscard]] constexpr V Apply(const V& value) const { return m_lhs.Apply(m_rhs.Apply(value)); }
+	[[nodiscard]] constexpr MatrixType Evaluate() const { return m_lhs.Evaluate() * m_rhs.Evaluate(); }
+	constexpr operator MatrixType() const { return Evaluate(); }
+
+private:
+	Lhs m_lhs;
+	Rhs m_rhs;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N, typename T>
+constexpr LazyMatrix<N, T> Lazy(const Matrix<N, T>& matrix)
+{
+	return LazyMatrix<N, T>(matrix);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename Lhs, typename Rhs, typename = std::enable_if_t<IS_MATRIX_EXPRESSION<Lhs> && IS_MATRIX_EXPRESSION<Rhs>>>
+constexpr MatrixProduct<Lhs, Rhs> operator*(const Lhs& lhs, const Rhs& rhs)
+{
+	return MatrixProduct<Lhs, Rhs>(lhs, rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Anything a Matrix can multiply (Tuple, Point3, Vector3, Normal3) evaluates the chain.
+template <typename E, typename V>
+constexpr auto operator*(const E& expression, const V& value)
+	-> std::enable_if_t<IS_MATRIX_EXPRESSION<E> && !IS_MATRIX_EXPRESSION<V>, decltype(expression.Apply(value))>
+{
+	return expression.Apply(value);
+}
+
+#endif // !MATRIX_EXPRESSION_H_
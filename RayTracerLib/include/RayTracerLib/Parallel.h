@@ -0,0 +1,48 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 0 means one thread per hardware thread.
+inline size_t ResolveThreadCount(const size_t threadCount)
+{
+	if (threadCount != 0)
+		return threadCount;
+
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Runs kernel(begin, end) over [0, count) on up to `threadCount` threads. Chunk boundaries are multiples of
+// `granularity`, so only the last chunk can end on a partial step. The calling thread takes the first chunk.
+template <typename Kernel>
+void ParallelForChunks(const size_t count, const size_t threadCount, const size_t granularity, const Kernel& kernel)
+{
+	const size_t stepCount = (count + granularity - 1) / granularity;
+	const size_t chunkCount = std::min(ResolveThreadCount(threadCount), std::max<size_t>(1, stepCount));
+	if (chunkCount == 1)
+	{
+		kernel(size_t(0), count);
+		return;
+	}
+
+	const size_t chunkSize = ((stepCount + chunkCount - 1) / chunkCount) * granularity;
+	std::vector<std::thread> threads;
+	threads.reserve(chunkCount - 1);
+	for (size_t begin = chunkSize; begin < count; begin += chunkSize)
+	{
+		threads.emplace_back(kernel, begin, std::min(count, begin + chunkSize));
+	}
+
+	kernel(size_t(0), std::min(count, chunkSize));
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+#endif // !PARALLEL_H_
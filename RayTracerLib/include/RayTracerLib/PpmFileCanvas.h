@@ -0,0 +1,42 @@
+#ifndef PPM_FILE_CANVAS_H_
+#define PPM_FILE_CANVAS_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Canvas.h"
+#include "Color.h"
+
+// A binary P6 image on disk that is written one block of pixels at a time, for images too large to hold in memory as a
+// Canvas. The file is created at its full size up front and every block row is written at its final offset, so
+// blocks can arrive in any order and only the block being written needs to be in memory. Pixels that are never
+// written stay black. Not safe to use from several threads at once.
+class PpmFileCanvas
+{
+public:
+	// Throws std::runtime_error if the file cannot be created.
+	PpmFileCanvas(const std::string& path, uint32_t width, uint32_t height);
+
+	// Writes `block` with its top left pixel at (x, y). Throws std::out_of_range if the block does not fit and
+	// std::runtime_error if the write fails.
+	void WriteBlock(uint32_t x, uint32_t y, const Canvas& block);
+	// Reads back a written pixel, quantized to 8 bits per channel.
+	[[ nodiscard ]] Color PixelAt(uint32_t x, uint32_t y);
+	void Flush();
+
+	[[ nodiscard ]] uint32_t Width() const { return m_width; }
+	[[ nodiscard ]] uint32_t Height() const { return m_height; }
+
+private:
+	[[ nodiscard ]] std::streamoff PixelOffset(uint32_t x, uint32_t y) const;
+
+	std::fstream m_file;
+	uint32_t m_width;
+	uint32_t m_height;
+	std::streamoff m_dataOffset;
+	std::vector<char> m_row;
+};
+
+#endif // !PPM_FILE_CANVAS_H_
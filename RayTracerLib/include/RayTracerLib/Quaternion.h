@@ -0,0 +1,298 @@
+#ifndef QUATERNION_H_
+#define QUATERNION_H_
+
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "AffineTransform.h"
+#include "Matrix.h"
+#include "RayMath.h"
+#include "Tuple.h"
+#include "TupleTypes.h"
+
+// A rotation stored as a unit quaternion x i + y j + z k + w. Products compose like matrices, (a * b) rotates by b
+// first and then by a, so ToMatrix(a * b) == ToMatrix(a) * ToMatrix(b). Composing two rotations is 16 multiplies
+// against 64 for 4x4 matrices, and renormalizing removes the drift repeated products accumulate.
+template <typename T = float>
+struct QuaternionT
+{
+	static_assert(std::is_floating_point_v<T>);
+	using Scalar = T;
+
+	QuaternionT() = default;
+	constexpr QuaternionT(const T x, const T y, const T z, const T w) : x(x), y(y), z(z), w(w) {}
+
+	[[ nodiscard ]] static constexpr QuaternionT Identity() { return {T(0), T(0), T(0), T(1)}; }
+	// Rotation by `radians` around `axis`, which does not need to be normalized.
+	[[ nodiscard ]] static QuaternionT FromAxisAngle(const TupleT<T>& axis, T radians);
+	// The rotation part of a transform without scale or shear.
+	[[ nodiscard ]] static QuaternionT FromMatrix(const Matrix<4, T>& matrix);
+	[[ nodiscard ]] static QuaternionT FromAffine(const AffineTransformT<T>& transform)
+	{
+		return FromMatrix(transform.ToMatrix());
+	}
+
+	[[ nodiscard ]] constexpr QuaternionT Conjugate() const { return {-x, -y, -z, w}; }
+	[[ nodiscard ]] constexpr T Magnitude() const;
+	[[ nodiscard ]] constexpr QuaternionT Normalize() const;
+	// For unit quaternions the inverse rotation is the conjugate.
+	[[ nodiscard ]] constexpr QuaternionT Inverse() const { return Conjugate(); }
+
+	// Rotates around the origin, w is kept so points and vectors both come out right.
+	[[ nodiscard ]] constexpr TupleT<T> Rotate(const TupleT<T>& tuple) const;
+
+	[[ nodiscard ]] constexpr Matrix<4, T> ToMatrix() const;
+	[[ nodiscard ]] AffineTransformT<T> ToAffine() const { return AffineTransformT<T>(ToMatrix()); }
+
+	T x;
+	T y;
+	T z;
+	T w;
+};
+
+using Quaternion = QuaternionT<float>;
+using Quaterniond = QuaternionT<double>;
+
+template <typename T>
+constexpr bool operator==(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs);
+template <typename T>
+constexpr bool operator!=(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs);
+template <typename T>
+constexpr QuaternionT<T> operator*(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs);
+template <typename T>
+constexpr T Dot(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs);
+
+// Normalized linear interpolation. Cheaper than Slerp but does not rotate at constant speed, fine for small steps
+// between keyframes.
+template <typename T>
+[[ nodiscard ]] constexpr QuaternionT<T> Nlerp(const QuaternionT<T>& from, QuaternionT<T> to,
+	typename QuaternionT<T>::Scalar t);
+// Spherical linear interpolation along the shorter arc at constant angular speed.
+template <typename T>
+[[ nodiscard ]] QuaternionT<T> Slerp(const QuaternionT<T>& from, QuaternionT<T> to, typename QuaternionT<T>::Scalar t);
+
+template <typename T>
+[[ nodiscard ]] std::string ToString(const QuaternionT<T>& quaternion);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+QuaternionT<T> QuaternionT<T>::FromAxisAngle(const TupleT<T>& axis, const T radians)
+{
+	const TupleT<T> unitAxis = TupleT<T>::CreateVector(axis.x, axis.y, axis.z).Normalize();
+	const T sin = std::sin(radians / T(2));
+	return {unitAxis.x * sin, unitAxis.y * sin, unitAxis.z * sin, std::cos(radians / T(2))};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Picks the largest of w, x, y and z to divide by, which keeps the result accurate for any rotation angle.
+template <typename T>
+QuaternionT<T> QuaternionT<T>::FromMatrix(const Matrix<4, T>& matrix)
+{
+	const auto& m = matrix.m_elements;
+	const T trace = m[0][0] + m[1][1] + m[2][2];
+
+	QuaternionT<T> result;
+	if (trace > T(0))
+	{
+		const T s = std::sqrt(trace + T(1)) * T(2);
+		result = {(m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s, s / T(4)};
+	}
+	else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+	{
+		const T s = std::sqrt(T(1) + m[0][0] - m[1][1] - m[2][2]) * T(2);
+		result = {s / T(4), (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s};
+	}
+	else if (m[1][1] > m[2][2])
+	{
+		const T s = std::sqrt(T(1) + m[1][1] - m[0][0] - m[2][2]) * T(2);
+		result = {(m[0][1] + m[1][0]) / s, s / T(4), (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s};
+	}
+	else
+	{
+		const T s = std::sqrt(T(1) + m[2][2] - m[0][0] - m[1][1]) * T(2);
+		result = {(m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, s / T(4), (m[1][0] - m[0][1]) / s};
+	}
+
+	return result.Normalize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr T QuaternionT<T>::Magnitude() const
+{
+	return Sqrt(Dot(*this, *this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr QuaternionT<T> QuaternionT<T>::Normalize() const
+{
+	const T inverseMagnitude = T(1) / Magnitude();
+	return {x * inverseMagnitude, y * inverseMagnitude, z * inverseMagnitude, w * inverseMagnitude};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// v' = v + w t + q x t with t = 2 (q x v), two cross products instead of the two quaternion products of q v q*.
+template <typename T>
+constexpr TupleT<T> QuaternionT<T>::Rotate(const TupleT<T>& tuple) const
+{
+	const T tx = T(2) * (y * tuple.z - z * tuple.y);
+	const T ty = T(2) * (z * tuple.x - x * tuple.z);
+	const T tz = T(2) * (x * tuple.y - y * tuple.x);
+
+	return {
+		tuple.x + w * tx + (y * tz - z * ty),
+		tuple.y + w * ty + (z * tx - x * tz),
+		tuple.z + w * tz + (x * ty - y * tx),
+		tuple.w
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr Matrix<4, T> QuaternionT<T>::ToMatrix() const
+{
+	const T xx = x * x;
+	const T yy = y * y;
+	const T zz = z * z;
+	const T xy = x * y;
+	const T xz = x * z;
+	const T yz = y * z;
+	const T wx = w * x;
+	const T wy = w * y;
+	const T wz = w * z;
+
+	return Make4x4Matrix<T>({
+		T(1) - T(2) * (yy + zz), T(2) * (xy - wz), T(2) * (xz + wy), T(0),
+		T(2) * (xy + wz), T(1) - T(2) * (xx + zz), T(2) * (yz - wx), T(0),
+		T(2) * (xz - wy), T(2) * (yz + wx), T(1) - T(2) * (xx + yy), T(0),
+		T(0), T(0), T(0), T(1),
+	});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool operator==(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs)
+{
+	return Equal(lhs.x, rhs.x) && Equal(lhs.y, rhs.y) && Equal(lhs.z, rhs.z) && Equal(lhs.w, rhs.w);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool operator!=(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs)
+{
+	return !(lhs == rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr QuaternionT<T> operator*(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs)
+{
+	return {
+		lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+		lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+		lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+		lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr T Dot(const QuaternionT<T>& lhs, const QuaternionT<T>& rhs)
+{
+	return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> operator*(const QuaternionT<T>& lhs, const TupleT<T>& rhs)
+{
+	return lhs.Rotate(rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Point3 operator*(const Quaternion& lhs, const Point3& rhs)
+{
+	return Point3(lhs.Rotate(rhs.ToTuple()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Vector3 operator*(const Quaternion& lhs, const Vector3& rhs)
+{
+	return Vector3(lhs.Rotate(rhs.ToTuple()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// q and -q are the same rotation, `to` is flipped when needed so the interpolation takes the shorter arc.
+template <typename T>
+constexpr QuaternionT<T> Nlerp(const QuaternionT<T>& from, QuaternionT<T> to, const typename QuaternionT<T>::Scalar t)
+{
+	if (Dot(from, to) < T(0))
+		to = {-to.x, -to.y, -to.z, -to.w};
+
+	const T s = T(1) - t;
+	return QuaternionT<T>(
+		s * from.x + t * to.x,
+		s * from.y + t * to.y,
+		s * from.z + t * to.z,
+		s * from.w + t * to.w).Normalize();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+QuaternionT<T> Slerp(const QuaternionT<T>& from, QuaternionT<T> to, const typename QuaternionT<T>::Scalar t)
+{
+	T cosAngle = Dot(from, to);
+	if (cosAngle < T(0))
+	{
+		to = {-to.x, -to.y, -to.z, -to.w};
+		cosAngle = -cosAngle;
+	}
+
+	// Nearly parallel, sin(angle) is too small to divide by and the arc is close enough to a straight line.
+	if (cosAngle > T(1) - Epsilon<T>)
+		return Nlerp(from, to, t);
+
+	const T angle = std::acos(cosAngle);
+	const T inverseSin = T(1) / std::sin(angle);
+	const T fromWeight = std::sin((T(1) - t) * angle) * inverseSin;
+	const T toWeight = std::sin(t * angle) * inverseSin;
+
+	return {
+		fromWeight * from.x + toWeight * to.x,
+		fromWeight * from.y + toWeight * to.y,
+		fromWeight * from.z + toWeight * to.z,
+		fromWeight * from.w + toWeight * to.w
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+std::string ToString(const QuaternionT<T>& quaternion)
+{
+	std::stringstream ss;
+	ss << "Quaternion {" << quaternion.x << ", " << quaternion.y << ", " << quaternion.z << ", " << quaternion.w << "}";
+
+	return ss.str();
+}
+
+#endif // !QUATERNION_H_
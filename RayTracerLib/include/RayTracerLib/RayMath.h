@@ -2,26 +2,80 @@
 #define RAY_MATH_H_
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
-constexpr auto EPSILON = 0.00001f;
+#include "Simd.h"
 
-bool Equalf(float a, float b);
+// RAYTRACER_HEADER_ONLY_MATH moves the out-of-line parts of the math core (RayMath, Tuple, TupleTypes, Color) from
+// RayTracerLib into every including translation unit, so they inline without link time optimization.
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+	#define RAYTRACER_MATH_API inline
+#else
+	#define RAYTRACER_MATH_API
+#endif
 
+// Tolerance of Equal and every comparison built on it, tighter for double so double precision scenes keep the
+// detail they were made for.
 template <typename T>
-T Abs(T val)
+constexpr T Epsilon = static_cast<T>(0.00001);
+template <>
+constexpr double Epsilon<double> = 1.0e-9;
+
+constexpr auto EPSILON = Epsilon<float>;
+constexpr auto PI = 3.14159265358979323846f;
+
+RAYTRACER_MATH_API bool Equalf(float a, float b);
+
+template <typename T>
+constexpr T Abs(T val)
 {
 	return val < 0 ? -val : val;
 }
 
 template <typename T>
-bool Equal(T a, T b)
+constexpr bool Equal(T a, T b)
+{
+	return (Abs(a - b) < Epsilon<T>);
+}
+
+#if defined(RAYTRACER_SSE)
+
+inline uint32_t EqualMask4Sse(const float* lhs, const float* rhs)
 {
-	return (Abs(a - b) < EPSILON);
+	const __m128 difference = _mm_sub_ps(_mm_loadu_ps(lhs), _mm_loadu_ps(rhs));
+	const __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), difference);
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(magnitude, _mm_set1_ps(EPSILON))));
+}
+
+#endif
+
+// Equal over four consecutive floats at once. Bit i of the result is set when lhs[i] and rhs[i] are equal, neither
+// pointer needs to be aligned.
+constexpr uint32_t EqualMask4(const float* lhs, const float* rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+		return EqualMask4Sse(lhs, rhs);
+#endif
+
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		mask |= static_cast<uint32_t>(Equal(lhs[i], rhs[i])) << i;
+	}
+
+	return mask;
 }
 
+// Bulk comparisons of two float arrays of `count` elements with the Equal tolerance.
+[[ nodiscard ]] RAYTRACER_MATH_API size_t CountNotEqual(const float* lhs, const float* rhs, size_t count);
+[[ nodiscard ]] RAYTRACER_MATH_API bool AllEqual(const float* lhs, const float* rhs, size_t count);
+
 template <typename T>
-T Clamp(T val, T min, T max)
+constexpr T Clamp(T val, T min, T max)
 {
 	if (val < min)
 		return min;
@@ -31,4 +85,101 @@ T Clamp(T val, T min, T max)
 	return val;
 }
 
+// Newton's method from above, stops once the iterate no longer decreases, which is the correctly rounded root or
+// one ulp off. Floats are iterated in double. Only meant for constant evaluation, see Sqrt.
+template <typename T>
+constexpr T ConstexprSqrt(const T val)
+{
+	if (!(val > T(0)))
+		return val == T(0) ? T(0) : std::numeric_limits<T>::quiet_NaN();
+	if (val == std::numeric_limits<T>::infinity())
+		return val;
+
+	using Wide = std::conditional_t<std::is_same_v<T, float>, double, T>;
+	const Wide x = val;
+	Wide current = x >= Wide(1) ? x : Wide(1);
+	while (true)
+	{
+		const Wide next = Wide(0.5) * (current + x / current);
+		if (!(next < current))
+			break;
+		current = next;
+	}
+
+	return static_cast<T>(current);
+}
+
+template <typename T>
+constexpr T Sqrt(T val)
+{
+	if (RAYTRACER_IS_CONSTANT_EVALUATED())
+		return ConstexprSqrt(val);
+
+	return std::sqrt(val);
+}
+
+// Taylor series of sin (`cosine` false) or cos after reducing the angle to [-PI, PI]. Float is evaluated in double, so
+// the result is correctly rounded for the angles a scene uses.
+template <typename T>
+constexpr T ConstexprSinCos(const T radians, const bool cosine)
+{
+	using Wide = std::conditional_t<std::is_same_v<T, float>, double, T>;
+	constexpr Wide twoPi = Wide(6.28318530717958647692528676655900577);
+
+	const Wide turns = radians / twoPi;
+	// NaN, infinity and angles too large to reduce exactly.
+	if (!(Abs(turns) < Wide(1.0e15)))
+		return std::numeric_limits<T>::quiet_NaN();
+
+	const auto wholeTurns = static_cast<int64_t>(turns < Wide(0) ? turns - Wide(0.5) : turns + Wide(0.5));
+	const Wide x = radians - static_cast<Wide>(wholeTurns) * twoPi;
+
+	Wide term = cosine ? Wide(1) : x;
+	Wide sum = term;
+	for (int n = cosine ? 1 : 2; ; n += 2)
+	{
+		term *= -x * x / (Wide(n) * Wide(n + 1));
+		const Wide next = sum + term;
+		if (next == sum)
+			break;
+		sum = next;
+	}
+
+	return static_cast<T>(sum);
+}
+
+template <typename T>
+constexpr T ConstexprSin(const T radians)
+{
+	return ConstexprSinCos(radians, false);
+}
+
+template <typename T>
+constexpr T ConstexprCos(const T radians)
+{
+	return ConstexprSinCos(radians, true);
+}
+
+template <typename T>
+constexpr T Sin(T radians)
+{
+	if (RAYTRACER_IS_CONSTANT_EVALUATED())
+		return ConstexprSin(radians);
+
+	return std::sin(radians);
+}
+
+template <typename T>
+constexpr T Cos(T radians)
+{
+	if (RAYTRACER_IS_CONSTANT_EVALUATED())
+		return ConstexprCos(radians);
+
+	return std::cos(radians);
+}
+
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "impl/RayMathImpl.h"
+#endif
+
 #endif // !RAY_MATH_H_
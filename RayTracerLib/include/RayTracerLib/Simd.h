@@ -0,0 +1,100 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+// Instruction sets available to the math core. They follow the compiler's target flags, define RAYTRACER_NO_SIMD to
+// force the scalar code paths.
+#if !defined(RAYTRACER_NO_SIMD)
+	#if defined(__AVX2__)
+		#define RAYTRACER_AVX2 1
+	#endif
+
+	#if defined(__AVX__)
+		#define RAYTRACER_AVX 1
+	#endif
+
+	#if defined(__SSE4_1__) || defined(RAYTRACER_AVX)
+		#define RAYTRACER_SSE4_1 1
+	#endif
+
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define RAYTRACER_SSE 1
+	#endif
+#endif
+
+#if defined(RAYTRACER_AVX)
+	#include <immintrin.h>
+#elif defined(RAYTRACER_SSE4_1)
+	#include <smmintrin.h>
+#elif defined(RAYTRACER_SSE)
+	#include <emmintrin.h>
+#endif
+
+#include <cstddef>
+
+// Lets constexpr functions pick scalar code during constant evaluation and SIMD code at runtime. All supported
+// compilers provide the builtin in C++17 mode, without it everything takes the runtime path and cannot be constant
+// evaluated.
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+	#define RAYTRACER_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+	#define RAYTRACER_IS_CONSTANT_EVALUATED() false
+#endif
+
+// Thin wrapper over the native register of a given float lane count. Only widths the target supports are
+// specialized, callers test `available` and fall back to plain loops otherwise.
+template <size_t N>
+struct SimdRegister
+{
+	static constexpr bool available = false;
+	static constexpr size_t alignment = alignof(float);
+};
+
+#if defined(RAYTRACER_SSE)
+
+template <>
+struct SimdRegister<4>
+{
+	static constexpr bool available = true;
+	using Type = __m128;
+	static constexpr size_t alignment = alignof(Type);
+
+	static Type Load(const float* values) { return _mm_load_ps(values); }
+	static void Store(float* values, const Type value) { _mm_store_ps(values, value); }
+	static Type Broadcast(const float value) { return _mm_set1_ps(value); }
+	static Type Add(const Type lhs, const Type rhs) { return _mm_add_ps(lhs, rhs); }
+	static Type Sub(const Type lhs, const Type rhs) { return _mm_sub_ps(lhs, rhs); }
+	static Type Mul(const Type lhs, const Type rhs) { return _mm_mul_ps(lhs, rhs); }
+	static Type Div(const Type lhs, const Type rhs) { return _mm_div_ps(lhs, rhs); }
+	static Type Sqrt(const Type value) { return _mm_sqrt_ps(value); }
+	static Type Abs(const Type value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), value); }
+	static Type Negate(const Type value) { return _mm_xor_ps(_mm_set1_ps(-0.0f), value); }
+	static unsigned LessThanMask(const Type lhs, const Type rhs) { return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(lhs, rhs))); }
+};
+
+#endif
+
+#if defined(RAYTRACER_AVX)
+
+template <>
+struct SimdRegister<8>
+{
+	static constexpr bool available = true;
+	using Type = __m256;
+	static constexpr size_t alignment = alignof(Type);
+
+	static Type Load(const float* values) { return _mm256_load_ps(values); }
+	static void Store(float* values, const Type value) { _mm256_store_ps(values, value); }
+	static Type Broadcast(const float value) { return _mm256_set1_ps(value); }
+	static Type Add(const Type lhs, const Type rhs) { return _mm256_add_ps(lhs, rhs); }
+	static Type Sub(const Type lhs, const Type rhs) { return _mm256_sub_ps(lhs, rhs); }
+	static Type Mul(const Type lhs, const Type rhs) { return _mm256_mul_ps(lhs, rhs); }
+	static Type Div(const Type lhs, const Type rhs) { return _mm256_div_ps(lhs, rhs); }
+	static Type Sqrt(const Type value) { return _mm256_sqrt_ps(value); }
+	static Type Abs(const Type value) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value); }
+	static Type Negate(const Type value) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), value); }
+	static unsigned LessThanMask(const Type lhs, const Type rhs) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ))); }
+};
+
+#endif
+
+#endif // !SIMD_H_
@@ -0,0 +1,146 @@
+#ifndef TRANSFORM_H_
+#define TRANSFORM_H_
+
+#include "Matrix.h"
+#include "Tuple.h"
+#include "TupleTypes.h"
+
+// An object transform together with its inverse and inverse transpose. Both are computed on first use after the
+// matrix changes and kept until the next change, so transforming rays into object space and normals back out does
+// not invert anything per call. The cache is filled from const accessors and is not safe to fill from several threads
+// at once; read GetInverse() once before sharing a Transform between threads.
+//
+// The builders apply the new transform after the current one, so
+//   Transform().RotateX(PI / 2).Scale(5, 5, 5).Translate(10, 5, 7)
+// rotates first and translates last, the same as Translation * Scaling * RotationX.
+class Transform
+{
+public:
+	Transform() : m_matrix(Matrix4x4::Identity()), m_inverse(Matrix4x4::Identity()),
+		m_inverseTranspose(Matrix4x4::Identity()), m_isInverseValid(true)
+	{
+	}
+
+	explicit Transform(const Matrix4x4& matrix) : m_matrix(matrix), m_inverse(matrix), m_inverseTranspose(matrix)
+	{
+	}
+
+	Transform& Translate(float x, float y, float z);
+	Transform& Scale(float x, float y, float z);
+	Transform& RotateX(float radians);
+	Transform& RotateY(float radians);
+	Transform& RotateZ(float radians);
+	Transform& Shear(float xy, float xz, float yx, float yz, float zx, float zy);
+	// Applies `matrix` after the current transform.
+	Transform& Then(const Matrix4x4& matrix);
+	void SetMatrix(const Matrix4x4& matrix);
+
+	[[nodiscard]] const Matrix4x4& GetMatrix() const { return m_matrix; }
+	[[nodiscard]] const Matrix4x4& GetInverse() const;
+	[[nodiscard]] const Matrix4x4& GetInverseTranspose() const;
+
+	[[nodiscard]] Tuple ToObjectSpace(const Tuple& tuple) const { return GetInverse() * tuple; }
+	[[nodiscard]] Point3 ToObjectSpace(const Point3& point) const { return GetInverse() * point; }
+	[[nodiscard]] Vector3 ToObjectSpace(const Vector3& vector) const { return GetInverse() * vector; }
+	// Object space normal to world space.
+	[[nodiscard]] Normal3 ToWorldSpace(const Normal3& normal) const { return GetInverseTranspose() * normal; }
+
+private:
+	void UpdateInverse() const;
+
+	Matrix4x4 m_matrix;
+	mutable Matrix4x4 m_inverse;
+	mutable Matrix4x4 m_inverseTranspose;
+	mutable bool m_isInverseValid = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::Then(const Matrix4x4& matrix)
+{
+	m_matrix = matrix * m_matrix;
+	m_isInverseValid = false;
+	return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::Translate(const float x, const float y, const float z)
+{
+	return Then(Translation(x, y, z));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::Scale(const float x, const float y, const float z)
+{
+	return Then(Scaling(x, y, z));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::RotateX(const float radians)
+{
+	return Then(RotationX(radians));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::RotateY(const float radians)
+{
+	return Then(RotationY(radians));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::RotateZ(const float radians)
+{
+	return Then(RotationZ(radians));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline Transform& Transform::Shear(const float xy, const float xz, const float yx, const float yz, const float zx,
+	const float zy)
+{
+	return Then(Shearing(xy, xz, yx, yz, zx, zy));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void Transform::SetMatrix(const Matrix4x4& matrix)
+{
+	m_matrix = matrix;
+	m_isInverseValid = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline const Matrix4x4& Transform::GetInverse() const
+{
+	if (!m_isInverseValid)
+		UpdateInverse();
+
+	return m_inverse;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline const Matrix4x4& Transform::GetInverseTranspose() const
+{
+	if (!m_isInverseValid)
+		UpdateInverse();
+
+	return m_inverseTranspose;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void Transform::UpdateInverse() const
+{
+	m_inverse = m_matrix.Inverse();
+	m_inverseTranspose = m_inverse.Transpose();
+	m_isInverseValid = true;
+}
+
+#endif // !TRANSFORM_H_
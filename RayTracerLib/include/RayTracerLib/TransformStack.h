@@ -0,0 +1,53 @@
+#ifndef TRANSFORM_STACK_H_
+#define TRANSFORM_STACK_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "Matrix.h"
+#include "Transform.h"
+
+// Accumulates parent to child transforms while walking a hierarchy. Every level keeps its composed world transform
+// together with the lazily cached inverse of Transform, so popping back to a parent reuses the parent's inverse
+// instead of recomputing it.
+class TransformStack
+{
+public:
+	TransformStack();
+
+	// Starts a child level with the current world transform.
+	void Push();
+	// Returns to the parent level. The root level cannot be popped.
+	void Pop();
+	// Applies `local` in the space of the current level: world = world * local.
+	void Multiply(const Matrix4x4& local);
+
+	[[ nodiscard ]] const Transform& Top() const { return m_levels.back(); }
+	[[ nodiscard ]] const Matrix4x4& World() const { return Top().GetMatrix(); }
+	[[ nodiscard ]] const Matrix4x4& WorldInverse() const { return Top().GetInverse(); }
+	[[ nodiscard ]] size_t Depth() const { return m_levels.size(); }
+
+private:
+	std::vector<Transform> m_levels;
+};
+
+// A node of a transform hierarchy. Groups have children, leaves have none and name the object they place with
+// `leafIndex`.
+struct TransformNode
+{
+	Matrix4x4 local = Matrix4x4::Identity();
+	std::vector<TransformNode> children;
+	size_t leafIndex = 0;
+};
+
+struct FlattenedTransform
+{
+	size_t leafIndex;
+	Transform world;
+};
+
+// Bakes the hierarchy under `root` into one world transform per leaf, in depth-first order. The inverses are computed
+// here, so the results can be read from several threads without filling a cache at render time.
+[[ nodiscard ]] std::vector<FlattenedTransform> FlattenHierarchy(const TransformNode& root);
+
+#endif // !TRANSFORM_STACK_H_
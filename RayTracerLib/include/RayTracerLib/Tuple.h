@@ -2,37 +2,511 @@
 #define TUPLE_H_
 
 #include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
-struct Tuple
-{
-	Tuple() = default;
-	Tuple(float x, float y, float z, float w);
-	bool operator==(const Tuple& rhs) const;
-	bool operator!=(const Tuple& rhs) const;
-	Tuple operator+(const Tuple& rhs) const;
-	Tuple operator-(const Tuple& rhs) const;
-	Tuple operator-() const;
-
-	[[ nodiscard ]] bool IsVector() const;
-	[[ nodiscard ]] bool IsPoint() const;
-	[[ nodiscard ]] float Magnitude() const;
-	[[ nodiscard ]] Tuple Normalize() const;
-
-	float x;
-	float y;
-	float z;
-	float w;
-	
-	static Tuple CreateVector(float x, float y, float z);
-	static Tuple CreatePoint(float x, float y, float z);
+#include "RayMath.h"
+#include "Simd.h"
+
+// Point/vector validation of tuple addition and subtraction, checked in debug builds and tests and plain arithmetic
+// in release. It picks the default policy of inline functions, so every translation unit linked together must see
+// the same value: the CMake build sets it on RayTracerLib from the build configuration for all of its consumers.
+// Builds that do not define it fall back to NDEBUG.
+#if !defined(RAYTRACER_CHECKED_TUPLES)
+	#if defined(NDEBUG)
+		#define RAYTRACER_CHECKED_TUPLES 0
+	#else
+		#define RAYTRACER_CHECKED_TUPLES 1
+	#endif
+#endif
+
+// Normalization policies. PreciseNormalize divides by the square root of the squared length, FastNormalize
+// multiplies by a reciprocal square root estimate refined with one Newton-Raphson step. Define
+// RAYTRACER_FAST_NORMALIZE to make the fast path the default.
+struct PreciseNormalize {};
+struct FastNormalize {};
+
+#if defined(RAYTRACER_FAST_NORMALIZE)
+using DefaultNormalizePolicy = FastNormalize;
+#else
+using DefaultNormalizePolicy = PreciseNormalize;
+#endif
+
+// Upper bound of the per-component error of FastNormalize against PreciseNormalize. The hardware estimate has a
+// relative error below 1.5 * 2^-12, one Newton-Raphson step squares that to roughly 2^-23 plus a few ulp of rounding,
+// and every component of a normalized tuple is at most 1.
+constexpr float FAST_NORMALIZE_MAX_ERROR = 1.0e-6f;
+static_assert(FAST_NORMALIZE_MAX_ERROR < EPSILON, "Fast normalization must stay within the equality tolerance");
+
+// x, y, z and w are laid out contiguously on a boundary of their combined size, so a float tuple can be loaded into a
+// single SSE register. All arithmetic is constexpr: constant evaluation takes the scalar code, runtime calls on float
+// tuples take the SIMD code and double tuples use scalar code throughout.
+template <typename T>
+struct alignas(4 * sizeof(T)) TupleT
+{
+	static_assert(std::is_floating_point_v<T>);
+	using Scalar = T;
+
+	TupleT() = default;
+	constexpr TupleT(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+	constexpr bool operator==(const TupleT& rhs) const;
+	constexpr bool operator!=(const TupleT& rhs) const;
+	constexpr TupleT operator+(const TupleT& rhs) const;
+	constexpr TupleT operator-(const TupleT& rhs) const;
+	constexpr TupleT operator-() const;
+
+	[[ nodiscard ]] constexpr bool IsVector() const;
+	[[ nodiscard ]] constexpr bool IsPoint() const;
+	[[ nodiscard ]] constexpr T Magnitude() const;
+	template <typename Policy = DefaultNormalizePolicy>
+	[[ nodiscard ]] constexpr TupleT Normalize() const;
+
+	T x;
+	T y;
+	T z;
+	T w;
+
+	static constexpr TupleT CreateVector(T x, T y, T z);
+	static constexpr TupleT CreatePoint(T x, T y, T z);
+};
+
+using Tuple = TupleT<float>;
+using Tupled = TupleT<double>;
+
+static_assert(sizeof(Tuple) == 4 * sizeof(float), "Tuple must stay a packed group of four floats");
+static_assert(sizeof(Tupled) == 4 * sizeof(double), "Tupled must stay a packed group of four doubles");
+
+// Arithmetic policies for Add and Subtract. The checked policy throws std::invalid_argument when the result is
+// neither a point nor a vector, the unchecked one compiles down to the bare arithmetic.
+struct CheckedTupleArithmetic
+{
+	template <typename T>
+	static constexpr void CheckAdd(const TupleT<T>& result);
+	template <typename T>
+	static constexpr void CheckSubtract(const TupleT<T>& result);
 };
 
-Tuple operator*(const Tuple& lhs, float rhs);
-Tuple operator*(float lhs, const Tuple& rhs);
-Tuple operator/(const Tuple& lhs, float rhs);
-float Dot(const Tuple& lhs, const Tuple& rhs);
-Tuple Cross(const Tuple& lhs, const Tuple& rhs);
+struct UncheckedTupleArithmetic
+{
+	template <typename T>
+	static constexpr void CheckAdd(const TupleT<T>&) {}
+	template <typename T>
+	static constexpr void CheckSubtract(const TupleT<T>&) {}
+};
+
+using DefaultTupleArithmetic = std::conditional_t<RAYTRACER_CHECKED_TUPLES != 0, CheckedTupleArithmetic, UncheckedTupleArithmetic>;
+
+template <typename Policy = DefaultTupleArithmetic, typename T>
+constexpr TupleT<T> Add(const TupleT<T>& lhs, const TupleT<T>& rhs);
+template <typename Policy = DefaultTupleArithmetic, typename T>
+constexpr TupleT<T> Subtract(const TupleT<T>& lhs, const TupleT<T>& rhs);
+
+// The scalar operand is not deduced so that `tuple * 2` still converts the literal to the tuple's scalar type.
+template <typename T>
+constexpr TupleT<T> operator*(const TupleT<T>& lhs, typename TupleT<T>::Scalar rhs);
+template <typename T>
+constexpr TupleT<T> operator*(typename TupleT<T>::Scalar lhs, const TupleT<T>& rhs);
+template <typename T>
+constexpr TupleT<T> operator/(const TupleT<T>& lhs, typename TupleT<T>::Scalar rhs);
+template <typename T>
+constexpr T Dot(const TupleT<T>& lhs, const TupleT<T>& rhs);
+template <typename T>
+constexpr TupleT<T> Cross(const TupleT<T>& lhs, const TupleT<T>& rhs);
+// Bit i is set when component i (x, y, z, w) of lhs and rhs are Equal.
+template <typename T>
+constexpr uint32_t EqualMask(const TupleT<T>& lhs, const TupleT<T>& rhs);
+
+// Normalizes `count` tuples in place, float tuples four at a time in structure-of-arrays form when SSE is available.
+template <typename Policy = DefaultNormalizePolicy, typename T>
+void NormalizeMany(TupleT<T>* tuples, size_t count);
+
+template <typename T>
+[[ nodiscard ]] std::string ToString(const TupleT<T>& tuple);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(RAYTRACER_SSE)
+
+inline __m128 LoadTuple(const Tuple& tuple)
+{
+	return _mm_load_ps(&tuple.x);
+}
+
+inline Tuple StoreTuple(const __m128 value)
+{
+	Tuple result;
+	_mm_store_ps(&result.x, value);
+	return result;
+}
+
+// Sum of all four lanes, broadcast to every lane.
+inline __m128 HorizontalSum(const __m128 value)
+{
+	const __m128 swapped = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+	const __m128 pairs = _mm_add_ps(value, swapped);
+	const __m128 crossed = _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2));
+	return _mm_add_ps(pairs, crossed);
+}
+
+inline __m128 DotBroadcast(const __m128 lhs, const __m128 rhs)
+{
+#if defined(RAYTRACER_SSE4_1)
+	return _mm_dp_ps(lhs, rhs, 0xFF);
+#else
+	return HorizontalSum(_mm_mul_ps(lhs, rhs));
+#endif
+}
+
+// One Newton-Raphson refinement of the reciprocal square root estimate: y * (3 - x * y * y) / 2.
+inline __m128 ReciprocalSqrt(const __m128 value)
+{
+	const __m128 estimate = _mm_rsqrt_ps(value);
+	const __m128 correction = _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(value, estimate), estimate));
+	return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), correction);
+}
+
+// Runtime bodies of the constexpr operations below, kept out of line of the constexpr functions so that those only
+// ever hold literal types.
+inline Tuple AddSse(const Tuple& lhs, const Tuple& rhs)
+{
+	return StoreTuple(_mm_add_ps(LoadTuple(lhs), LoadTuple(rhs)));
+}
+
+inline Tuple SubtractSse(const Tuple& lhs, const Tuple& rhs)
+{
+	return StoreTuple(_mm_sub_ps(LoadTuple(lhs), LoadTuple(rhs)));
+}
+
+inline Tuple NegateSse(const Tuple& tuple)
+{
+	return StoreTuple(_mm_xor_ps(LoadTuple(tuple), _mm_set1_ps(-0.0f)));
+}
+
+inline Tuple ScaleSse(const Tuple& tuple, const float scale)
+{
+	return StoreTuple(_mm_mul_ps(LoadTuple(tuple), _mm_set1_ps(scale)));
+}
+
+inline Tuple DivideSse(const Tuple& tuple, const float divisor)
+{
+	return StoreTuple(_mm_div_ps(LoadTuple(tuple), _mm_set1_ps(divisor)));
+}
+
+inline float DotSse(const Tuple& lhs, const Tuple& rhs)
+{
+	return _mm_cvtss_f32(DotBroadcast(LoadTuple(lhs), LoadTuple(rhs)));
+}
+
+inline Tuple CrossSse(const Tuple& lhs, const Tuple& rhs)
+{
+	const __m128 a = LoadTuple(lhs);
+	const __m128 b = LoadTuple(rhs);
+	const __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 zxy = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+	const __m128 xyz = _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 wMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	return StoreTuple(_mm_and_ps(xyz, wMask));
+}
+
+template <typename Policy>
+Tuple NormalizeSse(const Tuple& tuple)
+{
+	const __m128 value = LoadTuple(tuple);
+	const __m128 lengthSquared = DotBroadcast(value, value);
+	if constexpr (std::is_same_v<Policy, FastNormalize>)
+	{
+		return StoreTuple(_mm_mul_ps(value, ReciprocalSqrt(lengthSquared)));
+	}
+	else
+	{
+		return StoreTuple(_mm_div_ps(value, _mm_sqrt_ps(lengthSquared)));
+	}
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool TupleT<T>::operator==(const TupleT& rhs) const
+{
+	return EqualMask(*this, rhs) == 0xF;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool TupleT<T>::operator!=(const TupleT& rhs) const
+{
+	return !(*this == rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr void CheckedTupleArithmetic::CheckAdd(const TupleT<T>& result)
+{
+	if (result.w >= T(2))
+		throw std::invalid_argument("Cannot add a point and vector");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr void CheckedTupleArithmetic::CheckSubtract(const TupleT<T>& result)
+{
+	if (result.w < T(0))
+		throw std::invalid_argument("Cannot subtract a point and vector");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename Policy, typename T>
+constexpr TupleT<T> Add(const TupleT<T>& lhs, const TupleT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+		{
+			const Tuple result = AddSse(lhs, rhs);
+			Policy::CheckAdd(result);
+			return result;
+		}
+	}
+#endif
+
+	const TupleT<T> result = {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
+	Policy::CheckAdd(result);
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename Policy, typename T>
+constexpr TupleT<T> Subtract(const TupleT<T>& lhs, const TupleT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+		{
+			const Tuple result = SubtractSse(lhs, rhs);
+			Policy::CheckSubtract(result);
+			return result;
+		}
+	}
+#endif
+
+	const TupleT<T> result = {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
+	Policy::CheckSubtract(result);
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> TupleT<T>::operator+(const TupleT& rhs) const
+{
+	return Add(*this, rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> TupleT<T>::operator-(const TupleT& rhs) const
+{
+	return Subtract(*this, rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> TupleT<T>::operator-() const
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return NegateSse(*this);
+	}
+#endif
+
+	return {-x, -y, -z, -w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool TupleT<T>::IsVector() const
+{
+	return Equal(w, T(0));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr bool TupleT<T>::IsPoint() const
+{
+	return Equal(w, T(1));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr T TupleT<T>::Magnitude() const
+{
+	return Sqrt(Dot(*this, *this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Constant evaluation always takes the precise path.
+template <typename T>
+template <typename Policy>
+constexpr TupleT<T> TupleT<T>::Normalize() const
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return NormalizeSse<Policy>(*this);
+	}
+#endif
+
+	if constexpr (std::is_same_v<Policy, FastNormalize>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return *this * (T(1) / Magnitude());
+	}
+
+	const auto magnitude = Magnitude();
+	return {
+		x / magnitude,
+		y / magnitude,
+		z / magnitude,
+		w / magnitude
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> TupleT<T>::CreateVector(const T x, const T y, const T z)
+{
+	return {x, y, z, T(0)};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> TupleT<T>::CreatePoint(const T x, const T y, const T z)
+{
+	return {x, y, z, T(1)};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> operator*(const TupleT<T>& lhs, const typename TupleT<T>::Scalar rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return ScaleSse(lhs, rhs);
+	}
+#endif
+
+	return {lhs.x * rhs, lhs.y * rhs, lhs.z * rhs, lhs.w * rhs};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> operator*(const typename TupleT<T>::Scalar lhs, const TupleT<T>& rhs)
+{
+	return operator*(rhs, lhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> operator/(const TupleT<T>& lhs, const typename TupleT<T>::Scalar rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return DivideSse(lhs, rhs);
+	}
+#endif
+
+	return {lhs.x / rhs, lhs.y / rhs, lhs.z / rhs, lhs.w / rhs};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr T Dot(const TupleT<T>& lhs, const TupleT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return DotSse(lhs, rhs);
+	}
+#endif
+
+	return (lhs.x * rhs.x) + (lhs.y * rhs.y) + (lhs.z * rhs.z) + (lhs.w * rhs.w);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr TupleT<T> Cross(const TupleT<T>& lhs, const TupleT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return CrossSse(lhs, rhs);
+	}
+#endif
+
+	return {
+		lhs.y * rhs.z - lhs.z * rhs.y,
+		lhs.z * rhs.x - lhs.x * rhs.z,
+		lhs.x * rhs.y - lhs.y * rhs.x,
+		T(0)
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+constexpr uint32_t EqualMask(const TupleT<T>& lhs, const TupleT<T>& rhs)
+{
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		if (!RAYTRACER_IS_CONSTANT_EVALUATED())
+			return EqualMask4Sse(&lhs.x, &rhs.x);
+	}
+#endif
+
+	return static_cast<uint32_t>(Equal(lhs.x, rhs.x))
+		| static_cast<uint32_t>(Equal(lhs.y, rhs.y)) << 1
+		| static_cast<uint32_t>(Equal(lhs.z, rhs.z)) << 2
+		| static_cast<uint32_t>(Equal(lhs.w, rhs.w)) << 3;
+}
 
-[[ nodiscard ]] std::string ToString(const Tuple& tuple);
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "impl/TupleImpl.h"
+#endif
 
-#endif // TUPLE_H_
\ No newline at end of file
+#endif // TUPLE_H_
@@ -0,0 +1,425 @@
+#ifndef TUPLE_PACKET_H_
+#define TUPLE_PACKET_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "RayMath.h"
+#include "Simd.h"
+#include "Tuple.h"
+
+// Widest packet the target has registers for.
+#if defined(RAYTRACER_AVX)
+constexpr size_t NATIVE_PACKET_WIDTH = 8;
+#else
+constexpr size_t NATIVE_PACKET_WIDTH = 4;
+#endif
+
+// One bit per lane, lane 0 in the lowest bit.
+template <size_t N>
+struct PacketMask
+{
+	static_assert(N <= 32);
+	static constexpr uint32_t ALL_LANES = (N == 32) ? 0xFFFFFFFFu : ((1u << N) - 1u);
+
+	[[ nodiscard ]] bool operator[](const size_t lane) const { return (bits >> lane) & 1u; }
+	[[ nodiscard ]] bool All() const { return bits == ALL_LANES; }
+	[[ nodiscard ]] bool Any() const { return bits != 0; }
+	[[ nodiscard ]] bool None() const { return bits == 0; }
+
+	PacketMask operator&(const PacketMask& rhs) const { return {bits & rhs.bits}; }
+	PacketMask operator|(const PacketMask& rhs) const { return {bits | rhs.bits}; }
+	PacketMask operator~() const { return {~bits & ALL_LANES}; }
+
+	uint32_t bits;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// N floats processed together. Uses the matching SSE/AVX register when the target has one, plain loops otherwise.
+// Aligned for the register's loads and stores, widths without one only need float alignment.
+template <size_t N>
+struct FloatLanes
+{
+	using Register = SimdRegister<N>;
+
+	static FloatLanes Broadcast(float value);
+
+	[[ nodiscard ]] float operator[](const size_t lane) const { return v[lane]; }
+	float& operator[](const size_t lane) { return v[lane]; }
+
+	alignas(Register::alignment) float v[N];
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> FloatLanes<N>::Broadcast(const float value)
+{
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Broadcast(value));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = value;
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> operator+(const FloatLanes<N>& lhs, const FloatLanes<N>& rhs)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Add(Register::Load(lhs.v), Register::Load(rhs.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = lhs.v[i] + rhs.v[i];
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> operator-(const FloatLanes<N>& lhs, const FloatLanes<N>& rhs)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Sub(Register::Load(lhs.v), Register::Load(rhs.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = lhs.v[i] - rhs.v[i];
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> operator*(const FloatLanes<N>& lhs, const FloatLanes<N>& rhs)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Mul(Register::Load(lhs.v), Register::Load(rhs.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = lhs.v[i] * rhs.v[i];
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> operator/(const FloatLanes<N>& lhs, const FloatLanes<N>& rhs)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Div(Register::Load(lhs.v), Register::Load(rhs.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = lhs.v[i] / rhs.v[i];
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> operator-(const FloatLanes<N>& lanes)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Negate(Register::Load(lanes.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = -lanes.v[i];
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> Sqrt(const FloatLanes<N>& lanes)
+{
+	using Register = SimdRegister<N>;
+	FloatLanes<N> result;
+	if constexpr (Register::available)
+	{
+		Register::Store(result.v, Register::Sqrt(Register::Load(lanes.v)));
+	}
+	else
+	{
+		for (size_t i = 0; i < N; ++i)
+			result.v[i] = std::sqrt(lanes.v[i]);
+	}
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Lanes where |lhs - rhs| < EPSILON, the per-lane version of Equal.
+template <size_t N>
+PacketMask<N> EqualMask(const FloatLanes<N>& lhs, const FloatLanes<N>& rhs)
+{
+	using Register = SimdRegister<N>;
+	if constexpr (Register::available)
+	{
+		const auto difference = Register::Abs(Register::Sub(Register::Load(lhs.v), Register::Load(rhs.v)));
+		return {Register::LessThanMask(difference, Register::Broadcast(EPSILON))};
+	}
+	else
+	{
+		uint32_t bits = 0;
+		for (size_t i = 0; i < N; ++i)
+			bits |= static_cast<uint32_t>(Equal(lhs.v[i], rhs.v[i])) << i;
+
+		return {bits};
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// N tuples in structure-of-arrays form: lane i of x, y, z and w together make up the i-th tuple.
+template <size_t N>
+struct TuplePacket
+{
+	using Lanes = FloatLanes<N>;
+	static constexpr size_t WIDTH = N;
+
+	static TuplePacket Broadcast(const Tuple& tuple);
+	// Gathers N consecutive tuples.
+	static TuplePacket Load(const Tuple* tuples);
+	// Scatters the lanes back to N consecutive tuples.
+	void Store(Tuple* tuples) const;
+
+	[[ nodiscard ]] Tuple Get(size_t lane) const;
+	void Set(size_t lane, const Tuple& tuple);
+
+	[[ nodiscard ]] Lanes Magnitude() const;
+	[[ nodiscard ]] TuplePacket Normalize() const;
+	[[ nodiscard ]] PacketMask<N> IsVector() const;
+	[[ nodiscard ]] PacketMask<N> IsPoint() const;
+
+	Lanes x;
+	Lanes y;
+	Lanes z;
+	Lanes w;
+};
+
+using TuplePacket4 = TuplePacket<4>;
+using TuplePacket8 = TuplePacket<8>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> TuplePacket<N>::Broadcast(const Tuple& tuple)
+{
+	return {Lanes::Broadcast(tuple.x), Lanes::Broadcast(tuple.y), Lanes::Broadcast(tuple.z), Lanes::Broadcast(tuple.w)};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> TuplePacket<N>::Load(const Tuple* tuples)
+{
+	TuplePacket<N> result;
+	for (size_t i = 0; i < N; ++i)
+		result.Set(i, tuples[i]);
+
+	return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+void TuplePacket<N>::Store(Tuple* tuples) const
+{
+	for (size_t i = 0; i < N; ++i)
+		tuples[i] = Get(i);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+Tuple TuplePacket<N>::Get(const size_t lane) const
+{
+	assert(lane < N);
+	return {x[lane], y[lane], z[lane], w[lane]};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+void TuplePacket<N>::Set(const size_t lane, const Tuple& tuple)
+{
+	assert(lane < N);
+	x[lane] = tuple.x;
+	y[lane] = tuple.y;
+	z[lane] = tuple.z;
+	w[lane] = tuple.w;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator+(const TuplePacket<N>& lhs, const TuplePacket<N>& rhs)
+{
+	return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator-(const TuplePacket<N>& lhs, const TuplePacket<N>& rhs)
+{
+	return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator-(const TuplePacket<N>& packet)
+{
+	return {-packet.x, -packet.y, -packet.z, -packet.w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Per-lane scale.
+template <size_t N>
+TuplePacket<N> operator*(const TuplePacket<N>& lhs, const FloatLanes<N>& rhs)
+{
+	return {lhs.x * rhs, lhs.y * rhs, lhs.z * rhs, lhs.w * rhs};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator*(const TuplePacket<N>& lhs, const float rhs)
+{
+	return lhs * FloatLanes<N>::Broadcast(rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator*(const float lhs, const TuplePacket<N>& rhs)
+{
+	return rhs * lhs;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator/(const TuplePacket<N>& lhs, const FloatLanes<N>& rhs)
+{
+	return {lhs.x / rhs, lhs.y / rhs, lhs.z / rhs, lhs.w / rhs};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> operator/(const TuplePacket<N>& lhs, const float rhs)
+{
+	return lhs / FloatLanes<N>::Broadcast(rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> Dot(const TuplePacket<N>& lhs, const TuplePacket<N>& rhs)
+{
+	return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> Cross(const TuplePacket<N>& lhs, const TuplePacket<N>& rhs)
+{
+	return {
+		lhs.y * rhs.z - lhs.z * rhs.y,
+		lhs.z * rhs.x - lhs.x * rhs.z,
+		lhs.x * rhs.y - lhs.y * rhs.x,
+		FloatLanes<N>::Broadcast(0.0f)
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+FloatLanes<N> TuplePacket<N>::Magnitude() const
+{
+	return Sqrt(Dot(*this, *this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+TuplePacket<N> TuplePacket<N>::Normalize() const
+{
+	return *this / Magnitude();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+PacketMask<N> TuplePacket<N>::IsVector() const
+{
+	return EqualMask(w, Lanes::Broadcast(0.0f));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template <size_t N>
+PacketMask<N> TuplePacket<N>::IsPoint() const
+{
+	return EqualMask(w, Lanes::Broadcast(1.0f));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Lanes whose tuples compare equal with the same EPSILON tolerance as Tuple::operator==.
+template <size_t N>
+PacketMask<N> EqualMask(const TuplePacket<N>& lhs, const TuplePacket<N>& rhs)
+{
+	return EqualMask(lhs.x, rhs.x) & EqualMask(lhs.y, rhs.y) & EqualMask(lhs.z, rhs.z) & EqualMask(lhs.w, rhs.w);
+}
+
+#endif // !TUPLE_PACKET_H_
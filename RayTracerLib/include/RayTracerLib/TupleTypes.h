@@ -0,0 +1,220 @@
+#ifndef TUPLE_TYPES_H_
+#define TUPLE_TYPES_H_
+
+#include <cassert>
+#include <cmath>
+#include <string>
+
+#include "RayMath.h"
+#include "Tuple.h"
+
+// Strongly typed counterparts of Tuple. The point/vector rules are enforced by the overload set instead of a runtime
+// check of w, which is implied by the type and not stored: adding two points or subtracting a point from a vector
+// does not compile.
+
+struct Vector3
+{
+	Vector3() = default;
+	constexpr Vector3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+	constexpr explicit Vector3(const Tuple& tuple) : x(tuple.x), y(tuple.y), z(tuple.z) { assert(tuple.IsVector()); }
+
+	[[ nodiscard ]] constexpr Tuple ToTuple() const { return {x, y, z, 0.0f}; }
+	[[ nodiscard ]] constexpr float Magnitude() const;
+	[[ nodiscard ]] constexpr Vector3 Normalize() const;
+
+	float x;
+	float y;
+	float z;
+};
+
+struct Point3
+{
+	Point3() = default;
+	constexpr Point3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+	constexpr explicit Point3(const Tuple& tuple) : x(tuple.x), y(tuple.y), z(tuple.z) { assert(tuple.IsPoint()); }
+
+	[[ nodiscard ]] constexpr Tuple ToTuple() const { return {x, y, z, 1.0f}; }
+
+	float x;
+	float y;
+	float z;
+};
+
+// A surface normal. It is a direction like Vector3 but is transformed by the inverse transpose of an object's
+// transform, keeping it a separate type stops it from being passed through the plain object transform by mistake.
+struct Normal3
+{
+	Normal3() = default;
+	constexpr Normal3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+	constexpr explicit Normal3(const Vector3& vector) : x(vector.x), y(vector.y), z(vector.z) {}
+
+	[[ nodiscard ]] constexpr Vector3 ToVector() const { return {x, y, z}; }
+	[[ nodiscard ]] constexpr Tuple ToTuple() const { return {x, y, z, 0.0f}; }
+	[[ nodiscard ]] constexpr Normal3 Normalize() const;
+
+	float x;
+	float y;
+	float z;
+};
+
+[[ nodiscard ]] RAYTRACER_MATH_API std::string ToString(const Vector3& vector);
+[[ nodiscard ]] RAYTRACER_MATH_API std::string ToString(const Point3& point);
+[[ nodiscard ]] RAYTRACER_MATH_API std::string ToString(const Normal3& normal);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr bool operator==(const Vector3& lhs, const Vector3& rhs)
+{
+	return Equal(lhs.x, rhs.x) && Equal(lhs.y, rhs.y) && Equal(lhs.z, rhs.z);
+}
+
+constexpr bool operator!=(const Vector3& lhs, const Vector3& rhs)
+{
+	return !(lhs == rhs);
+}
+
+constexpr bool operator==(const Point3& lhs, const Point3& rhs)
+{
+	return Equal(lhs.x, rhs.x) && Equal(lhs.y, rhs.y) && Equal(lhs.z, rhs.z);
+}
+
+constexpr bool operator!=(const Point3& lhs, const Point3& rhs)
+{
+	return !(lhs == rhs);
+}
+
+constexpr bool operator==(const Normal3& lhs, const Normal3& rhs)
+{
+	return Equal(lhs.x, rhs.x) && Equal(lhs.y, rhs.y) && Equal(lhs.z, rhs.z);
+}
+
+constexpr bool operator!=(const Normal3& lhs, const Normal3& rhs)
+{
+	return !(lhs == rhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Vector3 operator+(const Vector3& lhs, const Vector3& rhs)
+{
+	return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+constexpr Vector3 operator-(const Vector3& lhs, const Vector3& rhs)
+{
+	return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+constexpr Vector3 operator-(const Vector3& vector)
+{
+	return {-vector.x, -vector.y, -vector.z};
+}
+
+constexpr Vector3 operator*(const Vector3& lhs, const float rhs)
+{
+	return {lhs.x * rhs, lhs.y * rhs, lhs.z * rhs};
+}
+
+constexpr Vector3 operator*(const float lhs, const Vector3& rhs)
+{
+	return operator*(rhs, lhs);
+}
+
+constexpr Vector3 operator/(const Vector3& lhs, const float rhs)
+{
+	const float inverse = 1.0f / rhs;
+	return {lhs.x * inverse, lhs.y * inverse, lhs.z * inverse};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Point3 operator+(const Point3& lhs, const Vector3& rhs)
+{
+	return {lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z};
+}
+
+constexpr Point3 operator+(const Vector3& lhs, const Point3& rhs)
+{
+	return operator+(rhs, lhs);
+}
+
+constexpr Point3 operator-(const Point3& lhs, const Vector3& rhs)
+{
+	return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+constexpr Vector3 operator-(const Point3& lhs, const Point3& rhs)
+{
+	return {lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Normal3 operator-(const Normal3& normal)
+{
+	return {-normal.x, -normal.y, -normal.z};
+}
+
+constexpr Vector3 operator*(const Normal3& lhs, const float rhs)
+{
+	return {lhs.x * rhs, lhs.y * rhs, lhs.z * rhs};
+}
+
+constexpr Vector3 operator*(const float lhs, const Normal3& rhs)
+{
+	return operator*(rhs, lhs);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr float Dot(const Vector3& lhs, const Vector3& rhs)
+{
+	return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
+
+constexpr float Dot(const Normal3& lhs, const Vector3& rhs)
+{
+	return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
+
+constexpr float Dot(const Vector3& lhs, const Normal3& rhs)
+{
+	return Dot(rhs, lhs);
+}
+
+constexpr float Dot(const Normal3& lhs, const Normal3& rhs)
+{
+	return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+}
+
+constexpr Vector3 Cross(const Vector3& lhs, const Vector3& rhs)
+{
+	return {
+		lhs.y * rhs.z - lhs.z * rhs.y,
+		lhs.z * rhs.x - lhs.x * rhs.z,
+		lhs.x * rhs.y - lhs.y * rhs.x
+	};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr float Vector3::Magnitude() const
+{
+	return Sqrt(Dot(*this, *this));
+}
+
+constexpr Vector3 Vector3::Normalize() const
+{
+	return *this / Magnitude();
+}
+
+constexpr Normal3 Normal3::Normalize() const
+{
+	return Normal3(ToVector().Normalize());
+}
+
+#if defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "impl/TupleTypesImpl.h"
+#endif
+
+#endif // !TUPLE_TYPES_H_
@@ -0,0 +1,46 @@
+#ifndef COLOR_IMPL_H_
+#define COLOR_IMPL_H_
+
+#include <sstream>
+
+#include "../Color.h"
+
+template <typename T>
+std::string ToString(const ColorT<T>& color)
+{
+	std::stringstream ss;
+	ss << "Color: {" << color.r << ", " << color.g << ", " << color.b << "}";
+
+	return ss.str();
+}
+
+// Four colors are twelve consecutive floats, compared as three groups of four. A color differs when any of its
+// three bits in the combined equality mask is clear.
+RAYTRACER_MATH_API size_t CountNotEqual(const Color* lhs, const Color* rhs, const size_t count)
+{
+	const float* lhsFloats = &lhs->r;
+	const float* rhsFloats = &rhs->r;
+
+	size_t notEqual = 0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const size_t offset = i * 3;
+		const uint32_t mask = EqualMask4(lhsFloats + offset, rhsFloats + offset)
+			| EqualMask4(lhsFloats + offset + 4, rhsFloats + offset + 4) << 4
+			| EqualMask4(lhsFloats + offset + 8, rhsFloats + offset + 8) << 8;
+		for (uint32_t color = 0; color < 4; ++color)
+		{
+			notEqual += ((mask >> (color * 3)) & 0x7u) != 0x7u ? 1 : 0;
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		notEqual += (lhs[i] == rhs[i]) ? 0 : 1;
+	}
+
+	return notEqual;
+}
+
+#endif // !COLOR_IMPL_H_
@@ -0,0 +1,61 @@
+#ifndef RAY_MATH_IMPL_H_
+#define RAY_MATH_IMPL_H_
+
+#include "../RayMath.h"
+
+RAYTRACER_MATH_API bool Equalf(const float a, const float b)
+{
+	if (fabsf(a - b) < EPSILON)
+		return true;
+
+	return false;
+}
+
+RAYTRACER_MATH_API size_t CountNotEqual(const float* lhs, const float* rhs, const size_t count)
+{
+	constexpr uint8_t bitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+	size_t notEqual = 0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		notEqual += bitCount[~EqualMask4(lhs + i, rhs + i) & 0xF];
+	}
+
+	for (; i < count; ++i)
+	{
+		notEqual += Equal(lhs[i], rhs[i]) ? 0 : 1;
+	}
+
+	return notEqual;
+}
+
+RAYTRACER_MATH_API bool AllEqual(const float* lhs, const float* rhs, const size_t count)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint32_t mask = EqualMask4(lhs + i, rhs + i)
+			& EqualMask4(lhs + i + 4, rhs + i + 4)
+			& EqualMask4(lhs + i + 8, rhs + i + 8)
+			& EqualMask4(lhs + i + 12, rhs + i + 12);
+		if (mask != 0xF)
+			return false;
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		if (EqualMask4(lhs + i, rhs + i) != 0xF)
+			return false;
+	}
+
+	for (; i < count; ++i)
+	{
+		if (!Equal(lhs[i], rhs[i]))
+			return false;
+	}
+
+	return true;
+}
+
+#endif // !RAY_MATH_IMPL_H_
@@ -0,0 +1,75 @@
+#ifndef TUPLE_IMPL_H_
+#define TUPLE_IMPL_H_
+
+#include <sstream>
+
+#include "../Tuple.h"
+
+template <typename T>
+std::string ToString(const TupleT<T>& tuple)
+{
+	std::stringstream ss;
+	if (tuple.IsVector())
+		ss << "Vec ";
+	else if (tuple.IsPoint())
+		ss << "Point ";
+	else
+		ss << "Error ";
+	
+	ss << "{" << tuple.x << ", " << tuple.y << ", " << tuple.z << ", " << tuple.w << "}";
+
+	return ss.str();
+}
+
+template <typename Policy, typename T>
+void NormalizeMany(TupleT<T>* tuples, const size_t count)
+{
+	size_t i = 0;
+#if defined(RAYTRACER_SSE)
+	if constexpr (std::is_same_v<T, float>)
+	{
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = LoadTuple(tuples[i]);
+			__m128 y = LoadTuple(tuples[i + 1]);
+			__m128 z = LoadTuple(tuples[i + 2]);
+			__m128 w = LoadTuple(tuples[i + 3]);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+
+			const __m128 lengthSquared = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+				_mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+
+			if constexpr (std::is_same_v<Policy, FastNormalize>)
+			{
+				const __m128 scale = ReciprocalSqrt(lengthSquared);
+				x = _mm_mul_ps(x, scale);
+				y = _mm_mul_ps(y, scale);
+				z = _mm_mul_ps(z, scale);
+				w = _mm_mul_ps(w, scale);
+			}
+			else
+			{
+				const __m128 magnitude = _mm_sqrt_ps(lengthSquared);
+				x = _mm_div_ps(x, magnitude);
+				y = _mm_div_ps(y, magnitude);
+				z = _mm_div_ps(z, magnitude);
+				w = _mm_div_ps(w, magnitude);
+			}
+
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_store_ps(&tuples[i].x, x);
+			_mm_store_ps(&tuples[i + 1].x, y);
+			_mm_store_ps(&tuples[i + 2].x, z);
+			_mm_store_ps(&tuples[i + 3].x, w);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		tuples[i] = tuples[i].template Normalize<Policy>();
+	}
+}
+
+#endif // !TUPLE_IMPL_H_
@@ -0,0 +1,32 @@
+#ifndef TUPLE_TYPES_IMPL_H_
+#define TUPLE_TYPES_IMPL_H_
+
+#include <sstream>
+
+#include "../TupleTypes.h"
+
+RAYTRACER_MATH_API std::string ToString(const Vector3& vector)
+{
+	std::stringstream ss;
+	ss << "Vector3 {" << vector.x << ", " << vector.y << ", " << vector.z << "}";
+
+	return ss.str();
+}
+
+RAYTRACER_MATH_API std::string ToString(const Point3& point)
+{
+	std::stringstream ss;
+	ss << "Point3 {" << point.x << ", " << point.y << ", " << point.z << "}";
+
+	return ss.str();
+}
+
+RAYTRACER_MATH_API std::string ToString(const Normal3& normal)
+{
+	std::stringstream ss;
+	ss << "Normal3 {" << normal.x << ", " << normal.y << ", " << normal.z << "}";
+
+	return ss.str();
+}
+
+#endif // !TUPLE_TYPES_IMPL_H_
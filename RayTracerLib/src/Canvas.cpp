@@ -1,14 +1,233 @@
 #include "../include/RayTracerLib/Canvas.h"
+#include "../include/RayTracerLib/Parallel.h"
 #include "../include/RayTracerLib/RayMath.h"
 
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
 
-Canvas::Canvas(const uint32_t w, const uint32_t h): width(w), height(h)
+namespace {
+
+// Row-major canvases are read in place, tiled ones are gathered into a scratch row.
+class RowReader
+{
+public:
+	explicit RowReader(const Canvas& canvas) : m_canvas(canvas)
+	{
+		if (canvas.layout != CanvasLayout::RowMajor)
+			m_row.resize(canvas.width);
+	}
+
+	const Color* Row(const uint32_t y)
+	{
+		if (m_canvas.layout == CanvasLayout::RowMajor)
+			return m_canvas.pixels.data() + TwoDimensionToOne(m_canvas.width, 0, y);
+
+		m_canvas.ReadRow(y, m_row.data());
+		return m_row.data();
+	}
+
+private:
+	const Canvas& m_canvas;
+	std::vector<Color> m_row;
+};
+
+// Decimal text of every 8-bit channel value, written as three bytes with only the first `length` of them kept.
+struct ChannelText
+{
+	char digits[3];
+	uint8_t length;
+};
+
+constexpr std::array<ChannelText, 256> MakeChannelTexts()
+{
+	std::array<ChannelText, 256> texts = {};
+	for (size_t value = 0; value < texts.size(); ++value)
+	{
+		auto& text = texts[value];
+		if (value >= 100)
+		{
+			text.digits[0] = static_cast<char>('0' + value / 100);
+			text.digits[1] = static_cast<char>('0' + value / 10 % 10);
+			text.digits[2] = static_cast<char>('0' + value % 10);
+			text.length = 3;
+		}
+		else if (value >= 10)
+		{
+			text.digits[0] = static_cast<char>('0' + value / 10);
+			text.digits[1] = static_cast<char>('0' + value % 10);
+			text.length = 2;
+		}
+		else
+		{
+			text.digits[0] = static_cast<char>('0' + value);
+			text.length = 1;
+		}
+	}
+
+	return texts;
+}
+
+constexpr auto CHANNEL_TEXTS = MakeChannelTexts();
+
+// PPM file lines should not be longer than 70 chars. A value that would reach 70 starts a new line, and every canvas
+// row starts a new line.
+constexpr size_t PPM_MAX_LINE_LENGTH = 70;
+
+// Formats rows [firstRow, lastRow) as P3 pixel data starting at `out` and returns the end of the written text. The
+// buffer needs four bytes per channel.
+char* EncodePlainPpmRows(const Canvas& canvas, const uint32_t firstRow, const uint32_t lastRow, char* out)
+{
+	RowReader reader(canvas);
+	for (uint32_t y = firstRow; y < lastRow; ++y)
+	{
+		const Color* row = reader.Row(y);
+		size_t lineLength = 0;
+		for (uint32_t x = 0; x < canvas.width; ++x)
+		{
+			for (const float channel : {row[x].r, row[x].g, row[x].b})
+			{
+				const auto& text = CHANNEL_TEXTS[ColorFloatToUint8(channel)];
+				if (lineLength > 0)
+				{
+					if (lineLength + 1 + text.length >= PPM_MAX_LINE_LENGTH)
+					{
+						*out++ = '\n';
+						lineLength = 0;
+					}
+					else
+					{
+						*out++ = ' ';
+						++lineLength;
+					}
+				}
+
+				std::memcpy(out, text.digits, sizeof(text.digits));
+				out += text.length;
+				lineLength += text.length;
+			}
+		}
+
+		if (lineLength > 0)
+			*out++ = '\n';
+	}
+
+	return out;
+}
+
+// Whole pixels only, so a flush never splits one.
+constexpr size_t PPM_BUFFER_SIZE = 3 * 8192;
+
+std::string PpmHeader(const char* magic, const Canvas& canvas)
+{
+	return std::string(magic) + "\n" + std::to_string(canvas.width) + " " + std::to_string(canvas.height) + "\n255\n";
+}
+
+// Horizontal bands of rows that are encoded independently, one per thread. Lines never cross rows, so the bands
+// concatenate to the same file a single pass writes.
+uint32_t PpmBandCount(const Canvas& canvas, const size_t threadCount)
+{
+	return static_cast<uint32_t>(std::min<size_t>(ResolveThreadCount(threadCount), std::max<uint32_t>(1, canvas.height)));
+}
+
+uint32_t FirstRowOfBand(const Canvas& canvas, const uint32_t bandCount, const uint32_t band)
+{
+	return static_cast<uint32_t>(static_cast<uint64_t>(canvas.height) * band / bandCount);
+}
+
+std::string EncodePlainPpmBand(const Canvas& canvas, const uint32_t firstRow, const uint32_t lastRow)
+{
+	std::string band(static_cast<size_t>(canvas.width) * (lastRow - firstRow) * 3 * 4, '\0');
+	const char* const end = EncodePlainPpmRows(canvas, firstRow, lastRow, band.data());
+	band.resize(static_cast<size_t>(end - band.data()));
+	return band;
+}
+
+std::string EncodeBinaryPpmBand(const Canvas& canvas, const uint32_t firstRow, const uint32_t lastRow)
+{
+	std::string band(static_cast<size_t>(canvas.width) * (lastRow - firstRow) * 3, '\0');
+	RowReader reader(canvas);
+	char* out = band.data();
+	for (uint32_t y = firstRow; y < lastRow; ++y)
+	{
+		const Color* row = reader.Row(y);
+		for (uint32_t x = 0; x < canvas.width; ++x)
+		{
+			*out++ = static_cast<char>(ColorFloatToUint8(row[x].r));
+			*out++ = static_cast<char>(ColorFloatToUint8(row[x].g));
+			*out++ = static_cast<char>(ColorFloatToUint8(row[x].b));
+		}
+	}
+
+	return band;
+}
+
+template <typename Encoder>
+std::vector<std::string> EncodeBands(const Canvas& canvas, const uint32_t bandCount, const Encoder& encoder)
+{
+	std::vector<std::string> bands(bandCount);
+	ParallelForChunks(bandCount, bandCount, 1, [&](const size_t begin, const size_t end)
+	{
+		for (auto band = static_cast<uint32_t>(begin); band < end; ++band)
+		{
+			bands[band] = encoder(canvas, FirstRowOfBand(canvas, bandCount, band),
+				FirstRowOfBand(canvas, bandCount, band + 1));
+		}
+	});
+
+	return bands;
+}
+
+template <typename Sink>
+void EncodeBinaryPpm(const Canvas& canvas, const size_t threadCount, const Sink& sink)
+{
+	const auto header = PpmHeader("P6", canvas);
+	sink(header.data(), header.size());
+
+	const uint32_t bandCount = PpmBandCount(canvas, threadCount);
+	if (bandCount > 1)
+	{
+		for (const auto& band : EncodeBands(canvas, bandCount, EncodeBinaryPpmBand))
+			sink(band.data(), band.size());
+		return;
+	}
+
+	RowReader reader(canvas);
+	std::array<char, PPM_BUFFER_SIZE> buffer;
+	size_t used = 0;
+	for (uint32_t y = 0; y < canvas.height; ++y)
+	{
+		const Color* row = reader.Row(y);
+		for (uint32_t x = 0; x < canvas.width; ++x)
+		{
+			if (used == buffer.size())
+			{
+				sink(buffer.data(), used);
+				used = 0;
+			}
+
+			buffer[used++] = static_cast<char>(ColorFloatToUint8(row[x].r));
+			buffer[used++] = static_cast<char>(ColorFloatToUint8(row[x].g));
+			buffer[used++] = static_cast<char>(ColorFloatToUint8(row[x].b));
+		}
+	}
+
+	if (used > 0)
+		sink(buffer.data(), used);
+}
+
+}
+
+Canvas::Canvas(const uint32_t w, const uint32_t h, const CanvasLayout layout): width(w), height(h), layout(layout)
 {
-	const auto pixelCount = width * height;
+	const size_t pixelCount = layout == CanvasLayout::RowMajor
+		? static_cast<size_t>(width) * height
+		: TileCount() * CANVAS_TILE_SIZE * CANVAS_TILE_SIZE;
 	pixels.reserve(pixelCount);
 	const Color color(0.0f, 0.0f, 0.0f);
-	for (uint64_t i = 0; i < pixelCount; ++i)
+	for (size_t i = 0; i < pixelCount; ++i)
 	{
 		pixels.push_back(color);
 	};
@@ -16,75 +235,102 @@ Canvas::Canvas(const uint32_t w, const uint32_t h): width(w), height(h)
 
 void Canvas::WritePixel(const uint32_t x, const uint32_t y, const Color& color)
 {
-	const auto subscript = TwoDimensionToOne(width, x, y);
+	const auto subscript = PixelIndex(x, y);
 	pixels[subscript] = color;
 }
 
 Color Canvas::PixelAt(const uint32_t x, const uint32_t y) const
 {
-	const auto subscript = TwoDimensionToOne(width, x, y);
+	const auto subscript = PixelIndex(x, y);
 	return pixels[subscript];
 }
 
 void Canvas::Fill(const Color& color)
 {
-	const auto pixelCount = width * height;
 	for (auto& pixel : pixels)
 	{
 		pixel = color;
 	}
 }
 
-std::string Canvas::ToPpm() const
+void Canvas::ReadRow(const uint32_t y, Color* out) const
 {
-	auto addToLine = [] (std::stringstream &ppmSs, std::string& lineString, const std::string& color, const size_t maxLineLength)
+	if (layout == CanvasLayout::RowMajor)
 	{
-		const auto newLine = '\n';
-		const auto colorString = lineString.empty() ? color : std::string(" ") + color;
-		const auto newLineBeforeColor = lineString.length() >= (maxLineLength - colorString.length());
-		if (newLineBeforeColor)
-		{
-			ppmSs << lineString << newLine;
-			lineString.clear();
-			lineString += color;
-		}
-		else
-		{
-			lineString += colorString;
-		}	
-	};
-	std::stringstream ppmSs;
-	std::string lineString;
-	const auto newLine = '\n';
-	ppmSs << "P3" << newLine
-		<< width << " " << height << newLine
-		<< 255 << newLine
-	;
-	//PPM file lines should not be longer than 70 chars. If we reach 70 chars before the next canvas line then break. Also break on new canvas line
-	// The max single color length is 3 (for example for 255)
-	const auto maxLineLength = static_cast<uint32_t>(70);
-	for (uint32_t y = 0; y < height; ++y)
-	{
-		for (uint32_t x = 0; x < width; ++x)
-		{
-			const auto color = PixelAt(x, y);
-			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.r)), maxLineLength);
-			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.g)), maxLineLength);
-			addToLine(ppmSs, lineString, std::to_string(ColorFloatToUint8(color.b)), maxLineLength);	
-		}
+		std::copy_n(pixels.data() + TwoDimensionToOne(width, 0, y), width, out);
+		return;
+	}
 
-		if (!lineString.empty())
-		{
-			ppmSs << lineString << newLine;
-			lineString.clear();
-		}
+	for (uint32_t x = 0; x < width; x += CANVAS_TILE_SIZE)
+	{
+		out = std::copy_n(pixels.data() + PixelIndex(x, y), std::min(CANVAS_TILE_SIZE, width - x), out);
+	}
+}
+
+std::string Canvas::ToPpm(const size_t threadCount) const
+{
+	const auto header = PpmHeader("P3", *this);
+
+	const uint32_t bandCount = PpmBandCount(*this, threadCount);
+	if (bandCount > 1)
+	{
+		const auto bands = EncodeBands(*this, bandCount, EncodePlainPpmBand);
+		size_t size = header.size();
+		for (const auto& band : bands)
+			size += band.size();
+
+		std::string ppm;
+		ppm.reserve(size);
+		ppm += header;
+		for (const auto& band : bands)
+			ppm += band;
+		return ppm;
 	}
 
-	if (!lineString.empty())
+	// Every channel takes at most three digits and one separator.
+	std::string ppm(header.size() + static_cast<size_t>(width) * height * 3 * 4, '\0');
+	std::copy(header.begin(), header.end(), ppm.begin());
+	char* const begin = ppm.data() + header.size();
+	const char* const end = EncodePlainPpmRows(*this, 0, height, begin);
+	ppm.resize(header.size() + static_cast<size_t>(end - begin));
+
+	return ppm;
+}
+
+void Canvas::WriteBinaryPpm(std::ostream& stream, const size_t threadCount) const
+{
+	EncodeBinaryPpm(*this, threadCount, [&stream](const char* data, const size_t size)
+	{
+		if (!stream.write(data, static_cast<std::streamsize>(size)))
+			throw std::runtime_error("Failed to write the PPM image");
+	});
+}
+
+void Canvas::WriteBinaryPpm(std::FILE* file, const size_t threadCount) const
+{
+	EncodeBinaryPpm(*this, threadCount, [file](const char* data, const size_t size)
+	{
+		if (std::fwrite(data, 1, size, file) != size)
+			throw std::runtime_error("Failed to write the PPM image");
+	});
+}
+
+size_t CountDifferentPixels(const Canvas& lhs, const Canvas& rhs)
+{
+	if (lhs.width != rhs.width || lhs.height != rhs.height)
+		throw std::invalid_argument("Cannot compare canvases of different sizes");
+
+	if (lhs.layout == CanvasLayout::RowMajor && rhs.layout == CanvasLayout::RowMajor)
+		return CountNotEqual(lhs.pixels.data(), rhs.pixels.data(), lhs.pixels.size());
+
+	// The tile padding is not part of the image, compare row by row.
+	RowReader lhsReader(lhs);
+	RowReader rhsReader(rhs);
+	size_t count = 0;
+	for (uint32_t y = 0; y < lhs.height; ++y)
 	{
-		ppmSs << lineString << newLine;
-		lineString.clear();
+		count += CountNotEqual(lhsReader.Row(y), rhsReader.Row(y), lhs.width);
 	}
 
-	return ppmSs.str();
+	return count;
 }
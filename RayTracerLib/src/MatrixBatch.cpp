@@ -0,0 +1,32 @@
+#include "../include/RayTracerLib/MatrixBatch.h"
+#include "../include/RayTracerLib/Parallel.h"
+
+void InvertMatrices(const Matrix4x4* input, Matrix4x4* output, const size_t count, const size_t threadCount)
+{
+	ParallelForChunks(count, threadCount, 1, [input, output](const size_t begin, const size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			output[i] = input[i].Inverse();
+		}
+	});
+}
+
+void ComposeMatrices(const Matrix4x4* lhs, const Matrix4x4* rhs, Matrix4x4* output, const size_t count,
+	const size_t threadCount)
+{
+	ParallelForChunks(count, threadCount, 1, [lhs, rhs, output](const size_t begin, const size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+#if defined(RAYTRACER_SSE)
+			// Through a temporary, the output may alias either operand.
+			Matrix4x4 product = Matrix4x4::Identity();
+			MultiplySse(lhs[i], rhs[i], product);
+			output[i] = product;
+#else
+			output[i] = lhs[i] * rhs[i];
+#endif
+		}
+	});
+}
@@ -0,0 +1,77 @@
+#include "../include/RayTracerLib/PpmFileCanvas.h"
+
+#include <stdexcept>
+
+PpmFileCanvas::PpmFileCanvas(const std::string& path, const uint32_t width, const uint32_t height)
+	: m_file(path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary), m_width(width), m_height(height)
+{
+	const auto header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+	m_file.write(header.data(), static_cast<std::streamsize>(header.size()));
+	m_dataOffset = static_cast<std::streamoff>(header.size());
+
+	// Writing the last byte sizes the file, the bytes before it read back as zero.
+	const auto dataSize = static_cast<std::streamoff>(TwoDimensionToOne(width, 0, height) * 3);
+	if (dataSize > 0)
+	{
+		m_file.seekp(m_dataOffset + dataSize - 1);
+		m_file.put('\0');
+	}
+
+	if (!m_file)
+		throw std::runtime_error("Failed to create the PPM file " + path);
+}
+
+std::streamoff PpmFileCanvas::PixelOffset(const uint32_t x, const uint32_t y) const
+{
+	return m_dataOffset + static_cast<std::streamoff>(TwoDimensionToOne(m_width, x, y) * 3);
+}
+
+void PpmFileCanvas::WriteBlock(const uint32_t x, const uint32_t y, const Canvas& block)
+{
+	if (x > m_width || block.width > m_width - x || y > m_height || block.height > m_height - y)
+		throw std::out_of_range("The block does not fit in the PPM image");
+
+	std::vector<Color> pixels(block.width);
+	m_row.resize(static_cast<size_t>(block.width) * 3);
+	for (uint32_t row = 0; row < block.height; ++row)
+	{
+		block.ReadRow(row, pixels.data());
+		char* out = m_row.data();
+		for (const auto& pixel : pixels)
+		{
+			*out++ = static_cast<char>(ColorFloatToUint8(pixel.r));
+			*out++ = static_cast<char>(ColorFloatToUint8(pixel.g));
+			*out++ = static_cast<char>(ColorFloatToUint8(pixel.b));
+		}
+
+		m_file.seekp(PixelOffset(x, y + row));
+		m_file.write(m_row.data(), static_cast<std::streamsize>(m_row.size()));
+	}
+
+	if (!m_file)
+		throw std::runtime_error("Failed to write the PPM file");
+}
+
+Color PpmFileCanvas::PixelAt(const uint32_t x, const uint32_t y)
+{
+	if (x >= m_width || y >= m_height)
+		throw std::out_of_range("The pixel is outside the PPM image");
+
+	unsigned char channels[3] = {};
+	m_file.seekg(PixelOffset(x, y));
+	m_file.read(reinterpret_cast<char*>(channels), sizeof(channels));
+	if (!m_file)
+		throw std::runtime_error("Failed to read the PPM file");
+
+	return {
+		channels[0] / static_cast<float>(MAXIMUM_COLOR_VALUE),
+		channels[1] / static_cast<float>(MAXIMUM_COLOR_VALUE),
+		channels[2] / static_cast<float>(MAXIMUM_COLOR_VALUE)
+	};
+}
+
+void PpmFileCanvas::Flush()
+{
+	if (!m_file.flush())
+		throw std::runtime_error("Failed to write the PPM file");
+}
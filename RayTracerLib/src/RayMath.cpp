@@ -1,9 +1,5 @@
 #include "../include/RayTracerLib/RayMath.h"
 
-bool Equalf(const float a, const float b)
-{
-	if (fabsf(a - b) < EPSILON)
-		return true;
-
-	return false;
-}
\ No newline at end of file
+#if !defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "../include/RayTracerLib/impl/RayMathImpl.h"
+#endif
@@ -0,0 +1,58 @@
+#include "../include/RayTracerLib/TransformStack.h"
+
+#include <cassert>
+
+TransformStack::TransformStack()
+{
+	m_levels.emplace_back();
+}
+
+void TransformStack::Push()
+{
+	m_levels.push_back(m_levels.back());
+}
+
+void TransformStack::Pop()
+{
+	assert(m_levels.size() > 1);
+	m_levels.pop_back();
+}
+
+void TransformStack::Multiply(const Matrix4x4& local)
+{
+	Transform& top = m_levels.back();
+	top.SetMatrix(top.GetMatrix() * local);
+}
+
+namespace {
+
+void FlattenNode(const TransformNode& node, TransformStack& stack, std::vector<FlattenedTransform>& leaves)
+{
+	stack.Push();
+	stack.Multiply(node.local);
+
+	if (node.children.empty())
+	{
+		leaves.push_back({node.leafIndex, stack.Top()});
+		// Fill the inverse cache before anyone shares the result.
+		static_cast<void>(leaves.back().world.GetInverse());
+	}
+
+	for (const auto& child : node.children)
+	{
+		FlattenNode(child, stack, leaves);
+	}
+
+	stack.Pop();
+}
+
+}
+
+std::vector<FlattenedTransform> FlattenHierarchy(const TransformNode& root)
+{
+	std::vector<FlattenedTransform> leaves;
+	TransformStack stack;
+	FlattenNode(root, stack, leaves);
+
+	return leaves;
+}
@@ -0,0 +1,5 @@
+#include "../include/RayTracerLib/TupleTypes.h"
+
+#if !defined(RAYTRACER_HEADER_ONLY_MATH)
+#include "../include/RayTracerLib/impl/TupleTypesImpl.h"
+#endif
@@ -1,15 +1,28 @@
 #define CATCH_CONFIG_MAIN
 
 #include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <vector>
 
 #include <Catch2/catch.hpp>
 
 #include <RayTracerLib/Tuple.h>
+#include <RayTracerLib/TupleTypes.h>
+#include <RayTracerLib/TuplePacket.h>
 #include <RayTracerLib/RayMath.h>
 #include <RayTracerLib/Color.h>
 #include <RayTracerLib/Canvas.h>
+#include <RayTracerLib/PpmFileCanvas.h>
 #include <RayTracerLib/Matrix.h>
+#include <RayTracerLib/MatrixBatch.h>
+#include <RayTracerLib/MatrixExpression.h>
+#include <RayTracerLib/Quaternion.h>
+#include <RayTracerLib/AffineTransform.h>
+#include <RayTracerLib/Transform.h>
+#include <RayTracerLib/TransformStack.h>
 #include <RayTracerLib/RayMath.h>
 
 namespace Catch {
@@ -21,6 +34,34 @@ namespace Catch {
         }
     };
 
+	template<>
+    struct StringMaker<Tupled> {
+        static std::string convert( Tupled const& value ) {
+            return ToString(value);
+        }
+    };
+
+	template<>
+    struct StringMaker<Point3> {
+        static std::string convert( Point3 const& value ) {
+            return ToString(value);
+        }
+    };
+
+	template<>
+    struct StringMaker<Vector3> {
+        static std::string convert( Vector3 const& value ) {
+            return ToString(value);
+        }
+    };
+
+	template<>
+    struct StringMaker<Normal3> {
+        static std::string convert( Normal3 const& value ) {
+            return ToString(value);
+        }
+    };
+
 	template<>
     struct StringMaker<Color> {
         static std::string convert( Color const& value ) {
@@ -28,6 +69,13 @@ namespace Catch {
         }
     };
 
+	template<>
+    struct StringMaker<Colord> {
+        static std::string convert( Colord const& value ) {
+            return ToString(value);
+        }
+    };
+
 	template<>
     struct StringMaker<Matrix2x2> {
         static std::string convert( Matrix2x2 const& value ) {
@@ -48,8 +96,41 @@ namespace Catch {
             return ToString(value);
         }
     };
+
+	template<>
+    struct StringMaker<AffineTransform> {
+        static std::string convert( AffineTransform const& value ) {
+            return ToString(value);
+        }
+    };
+
+	template<>
+    struct StringMaker<Quaternion> {
+        static std::string convert( Quaternion const& value ) {
+            return ToString(value);
+        }
+    };
+
+	template<>
+    struct StringMaker<Matrix4x4d> {
+        static std::string convert( Matrix4x4d const& value ) {
+            return ToString(value);
+        }
+    };
 }
 
+template <typename L, typename R, typename = void>
+struct CanAdd : std::false_type {};
+
+template <typename L, typename R>
+struct CanAdd<L, R, std::void_t<decltype(std::declval<L>() + std::declval<R>())>> : std::true_type {};
+
+template <typename L, typename R, typename = void>
+struct CanSubtract : std::false_type {};
+
+template <typename L, typename R>
+struct CanSubtract<L, R, std::void_t<decltype(std::declval<L>() - std::declval<R>())>> : std::true_type {};
+
 TEST_CASE( "tuple is equal", "[tuple]" )
 {
     auto a = Tuple(4.3f, -4.2f, 3.1f, 1.0f);
@@ -104,6 +185,23 @@ TEST_CASE( "substracting a vector from the zero vector", "[tuple]" )
     REQUIRE((zero - v) ==  Tuple::CreateVector(-1.0f, 2.0f, -3.0f));
 }
 
+TEST_CASE( "checked arithmetic rejects adding two points", "[tuple]" )
+{
+    const auto p = Tuple::CreatePoint(1.0f, 2.0f, 3.0f);
+    const auto v = Tuple::CreateVector(1.0f, 2.0f, 3.0f);
+    REQUIRE(Add<CheckedTupleArithmetic>(p, v) == Tuple::CreatePoint(2.0f, 4.0f, 6.0f));
+    REQUIRE_THROWS_AS(Add<CheckedTupleArithmetic>(p, p), std::invalid_argument);
+    REQUIRE_THROWS_AS(Subtract<CheckedTupleArithmetic>(v, p), std::invalid_argument);
+}
+
+TEST_CASE( "unchecked arithmetic does not validate w", "[tuple]" )
+{
+    const auto p = Tuple::CreatePoint(1.0f, 2.0f, 3.0f);
+    const auto v = Tuple::CreateVector(1.0f, 2.0f, 3.0f);
+    REQUIRE(Add<UncheckedTupleArithmetic>(p, p) == Tuple(2.0f, 4.0f, 6.0f, 2.0f));
+    REQUIRE(Subtract<UncheckedTupleArithmetic>(v, p) == Tuple(0.0f, 0.0f, 0.0f, -1.0f));
+}
+
 TEST_CASE( "negating a tuple", "[tuple]" )
 {
     const auto a = Tuple(1.0f, -2.0f, 3.0f, -4.0f);
@@ -177,6 +275,44 @@ TEST_CASE( "The magniture of a normalized vector", "[tuple]" )
     REQUIRE(Equal(norm.Magnitude(), 1.0f));
 }
 
+TEST_CASE( "Fast normalization stays within its documented error bound", "[tuple]" )
+{
+	for (int i = -20; i <= 20; ++i)
+	{
+		const auto scale = std::ldexp(1.0f, i);
+		const auto a = Tuple::CreateVector(1.0f * scale, -2.0f * scale, 3.0f * scale + 0.1f * i);
+		const auto precise = a.Normalize<PreciseNormalize>();
+		const auto fast = a.Normalize<FastNormalize>();
+
+		REQUIRE(fast == precise);
+		REQUIRE(Abs(fast.x - precise.x) <= FAST_NORMALIZE_MAX_ERROR);
+		REQUIRE(Abs(fast.y - precise.y) <= FAST_NORMALIZE_MAX_ERROR);
+		REQUIRE(Abs(fast.z - precise.z) <= FAST_NORMALIZE_MAX_ERROR);
+		REQUIRE(fast.w == 0.0f);
+	}
+}
+
+TEST_CASE( "Normalizing many tuples at once", "[tuple]" )
+{
+	std::vector<Tuple> tuples;
+	for (int i = 0; i < 11; ++i)
+	{
+		tuples.push_back(Tuple::CreateVector(1.0f + i, 2.0f - i, 3.0f * i));
+	}
+
+	auto precise = tuples;
+	auto fast = tuples;
+	NormalizeMany<PreciseNormalize>(precise.data(), precise.size());
+	NormalizeMany<FastNormalize>(fast.data(), fast.size());
+
+	for (size_t i = 0; i < tuples.size(); ++i)
+	{
+		REQUIRE(precise[i] == tuples[i].Normalize<PreciseNormalize>());
+		REQUIRE(fast[i] == tuples[i].Normalize<PreciseNormalize>());
+		REQUIRE(Equal(fast[i].Magnitude(), 1.0f));
+	}
+}
+
 TEST_CASE( "The dot product of two tuples", "[tuple]" )
 {
     const auto a = Tuple::CreateVector(1.0f, 2.0f, 3.0f);
@@ -194,6 +330,157 @@ TEST_CASE( "The cross product of two tuples", "[tuple]" )
 	REQUIRE(Cross(b, a) == Tuple::CreateVector(1.0f, -2.0f, 1.0f));
 }
 
+TEST_CASE( "The cross product of two vectors is a vector", "[tuple]" )
+{
+	const auto a = Tuple::CreateVector(1.0f, 2.0f, 3.0f);
+	const auto b = Tuple::CreateVector(2.0f, 3.0f, 4.0f);
+
+	REQUIRE(Cross(a, b).IsVector());
+	REQUIRE(Cross(a, b) == Tuple::CreateVector(-1.0f, 2.0f, -1.0f));
+	REQUIRE(Cross(b, a) == Tuple::CreateVector(1.0f, -2.0f, 1.0f));
+}
+
+TEST_CASE( "Tuples are aligned for SIMD loads", "[tuple]" )
+{
+	REQUIRE(alignof(Tuple) == 16);
+	REQUIRE(sizeof(Tuple) == 16);
+
+	const Tuple tuples[3] = {};
+	for (const auto& tuple : tuples)
+	{
+		REQUIRE(reinterpret_cast<uintptr_t>(&tuple) % 16 == 0);
+	}
+}
+
+TEST_CASE( "Point and vector rules are checked at compile time", "[tuple3]" )
+{
+	STATIC_REQUIRE(std::is_same_v<decltype(Point3() + Vector3()), Point3>);
+	STATIC_REQUIRE(std::is_same_v<decltype(Vector3() + Point3()), Point3>);
+	STATIC_REQUIRE(std::is_same_v<decltype(Point3() - Vector3()), Point3>);
+	STATIC_REQUIRE(std::is_same_v<decltype(Point3() - Point3()), Vector3>);
+	STATIC_REQUIRE(std::is_same_v<decltype(Vector3() + Vector3()), Vector3>);
+	STATIC_REQUIRE_FALSE(CanAdd<Point3, Point3>::value);
+	STATIC_REQUIRE_FALSE(CanSubtract<Vector3, Point3>::value);
+	STATIC_REQUIRE_FALSE(CanAdd<Point3, Normal3>::value);
+}
+
+TEST_CASE( "Typed points and vectors follow tuple arithmetic", "[tuple3]" )
+{
+	const Point3 p(3.0f, 2.0f, 1.0f);
+	const Vector3 v(5.0f, 6.0f, 7.0f);
+
+	REQUIRE((p - Point3(5.0f, 6.0f, 7.0f)) == Vector3(-2.0f, -4.0f, -6.0f));
+	REQUIRE((p - v) == Point3(-2.0f, -4.0f, -6.0f));
+	REQUIRE((p + v) == Point3(8.0f, 8.0f, 8.0f));
+	REQUIRE(Equal(Dot(Vector3(1.0f, 2.0f, 3.0f), Vector3(2.0f, 3.0f, 4.0f)), 20.0f));
+	REQUIRE(Cross(Vector3(1.0f, 2.0f, 3.0f), Vector3(2.0f, 3.0f, 4.0f)) == Vector3(-1.0f, 2.0f, -1.0f));
+	REQUIRE(Vector3(1.0f, 2.0f, 3.0f).Normalize() == Vector3(0.26726f, 0.53452f, 0.80178f));
+	REQUIRE(Normal3(4.0f, 0.0f, 0.0f).Normalize() == Normal3(1.0f, 0.0f, 0.0f));
+}
+
+TEST_CASE( "Typed points and vectors convert to and from tuples", "[tuple3]" )
+{
+	const auto p = Tuple::CreatePoint(1.0f, 2.0f, 3.0f);
+	const auto v = Tuple::CreateVector(4.0f, 5.0f, 6.0f);
+
+	REQUIRE(Point3(p) == Point3(1.0f, 2.0f, 3.0f));
+	REQUIRE(Vector3(v) == Vector3(4.0f, 5.0f, 6.0f));
+	REQUIRE(Point3(p).ToTuple() == p);
+	REQUIRE(Vector3(v).ToTuple() == v);
+	REQUIRE(Normal3(Vector3(v)).ToTuple() == v);
+}
+
+TEMPLATE_TEST_CASE( "Tuple packets load and store tuples lane by lane", "[packet]", TuplePacket<3>, TuplePacket4, TuplePacket8 )
+{
+	constexpr auto width = TestType::WIDTH;
+	Tuple tuples[width];
+	for (size_t i = 0; i < width; ++i)
+	{
+		tuples[i] = Tuple::CreateVector(static_cast<float>(i), 1.0f, -static_cast<float>(i));
+	}
+
+	const auto packet = TestType::Load(tuples);
+	Tuple stored[width];
+	packet.Store(stored);
+
+	for (size_t i = 0; i < width; ++i)
+	{
+		REQUIRE(packet.Get(i) == tuples[i]);
+		REQUIRE(stored[i] == tuples[i]);
+	}
+}
+
+TEMPLATE_TEST_CASE( "Tuple packet math matches tuple math in every lane", "[packet]", TuplePacket<3>, TuplePacket4, TuplePacket8 )
+{
+	constexpr auto width = TestType::WIDTH;
+	Tuple lhs[width];
+	Tuple rhs[width];
+	for (size_t i = 0; i < width; ++i)
+	{
+		const auto f = static_cast<float>(i) + 1.0f;
+		lhs[i] = Tuple::CreateVector(f, 2.0f * f, 3.0f);
+		rhs[i] = Tuple::CreateVector(2.0f, -f, 4.0f * f);
+	}
+
+	const auto a = TestType::Load(lhs);
+	const auto b = TestType::Load(rhs);
+
+	const auto sum = a + b;
+	const auto difference = a - b;
+	const auto negated = -a;
+	const auto scaled = a * 3.5f;
+	const auto divided = a / 2.0f;
+	const auto cross = Cross(a, b);
+	const auto dot = Dot(a, b);
+	const auto magnitude = a.Magnitude();
+	const auto normalized = a.Normalize();
+
+	for (size_t i = 0; i < width; ++i)
+	{
+		REQUIRE(sum.Get(i) == lhs[i] + rhs[i]);
+		REQUIRE(difference.Get(i) == lhs[i] - rhs[i]);
+		REQUIRE(negated.Get(i) == -lhs[i]);
+		REQUIRE(scaled.Get(i) == lhs[i] * 3.5f);
+		REQUIRE(divided.Get(i) == lhs[i] / 2.0f);
+		REQUIRE(cross.Get(i) == Cross(lhs[i], rhs[i]));
+		REQUIRE(Equal(dot[i], Dot(lhs[i], rhs[i])));
+		REQUIRE(Equal(magnitude[i], lhs[i].Magnitude()));
+		REQUIRE(normalized.Get(i) == lhs[i].Normalize());
+	}
+}
+
+TEMPLATE_TEST_CASE( "Tuple packet comparisons produce per-lane masks", "[packet]", TuplePacket<3>, TuplePacket4, TuplePacket8 )
+{
+	constexpr auto width = TestType::WIDTH;
+	Tuple tuples[width];
+	Tuple others[width];
+	for (size_t i = 0; i < width; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		tuples[i] = (i % 2 == 0) ? Tuple::CreatePoint(f, f, f) : Tuple::CreateVector(f, f, f);
+		// Odd lanes differ by less than EPSILON, lanes divisible by 4 by more.
+		others[i] = tuples[i];
+		others[i].x += (i % 4 == 0) ? 10.0f * EPSILON : 0.1f * EPSILON;
+	}
+
+	const auto packet = TestType::Load(tuples);
+	const auto points = packet.IsPoint();
+	const auto vectors = packet.IsVector();
+	const auto equal = EqualMask(packet, TestType::Load(others));
+
+	for (size_t i = 0; i < width; ++i)
+	{
+		REQUIRE(points[i] == tuples[i].IsPoint());
+		REQUIRE(vectors[i] == tuples[i].IsVector());
+		REQUIRE(equal[i] == (tuples[i] == others[i]));
+	}
+
+	REQUIRE((points | vectors).All());
+	REQUIRE((points & vectors).None());
+	REQUIRE(equal.Any());
+	REQUIRE_FALSE(equal.All());
+}
+
 TEST_CASE( "Colors are (red, green, blue) tuples", "[color]" )
 {
     const auto c = Color(-0.5f, 0.4f, 1.7f);
@@ -230,6 +517,102 @@ TEST_CASE( "Multiplying colors", "[color]" )
 	REQUIRE((c1 * c2) == Color(0.9f, 0.2f, 0.04f));
 }
 
+TEST_CASE( "Scene constants are evaluated at compile time", "[tuple][color][constexpr]" )
+{
+	constexpr auto up = Tuple::CreateVector(0.0f, 1.0f, 0.0f);
+	constexpr auto origin = Tuple::CreatePoint(0.0f, 0.0f, 0.0f);
+	constexpr auto eye = origin + Tuple::CreateVector(0.0f, 1.5f, -5.0f);
+	constexpr auto forward = (origin - eye).Normalize();
+	constexpr auto left = Cross(forward, up);
+	constexpr auto halfwayLight = (Tuple::CreateVector(1.0f, 1.0f, 0.0f) / 2.0f) * 2.0f;
+
+	STATIC_REQUIRE(eye == Tuple::CreatePoint(0.0f, 1.5f, -5.0f));
+	STATIC_REQUIRE(forward.IsVector());
+	STATIC_REQUIRE(Equal(forward.Magnitude(), 1.0f));
+	STATIC_REQUIRE(Equal(Dot(left, up), 0.0f));
+	STATIC_REQUIRE(-up == Tuple::CreateVector(0.0f, -1.0f, 0.0f));
+	STATIC_REQUIRE(Equal(halfwayLight.Normalize<FastNormalize>().x, 0.70711f));
+	STATIC_REQUIRE(Equal(Vector3(3.0f, 4.0f, 0.0f).Magnitude(), 5.0f));
+
+	constexpr auto white = Color(1.0f, 1.0f, 1.0f);
+	constexpr auto lightIntensity = white * 0.8f;
+	constexpr auto ambient = HadamardProduct(lightIntensity, Color(1.0f, 0.2f, 1.0f)) * 0.1f;
+	STATIC_REQUIRE(ambient == Color(0.08f, 0.016f, 0.08f));
+	STATIC_REQUIRE((white - lightIntensity) + lightIntensity == white);
+
+	// The same expressions evaluated at runtime take the SIMD paths and must agree.
+	auto runtimeOrigin = origin;
+	REQUIRE((runtimeOrigin - eye).Normalize() == forward);
+	REQUIRE(Cross((runtimeOrigin - eye).Normalize(), up) == left);
+}
+
+TEST_CASE( "Equalf compares floats within EPSILON", "[math]" )
+{
+	REQUIRE(Equalf(1.0f, 1.0f + EPSILON * 0.5f));
+	REQUIRE_FALSE(Equalf(1.0f, 1.0f + EPSILON * 2.0f));
+	REQUIRE(Equalf(-3.5f, -3.5f));
+}
+
+TEST_CASE( "Equality masks flag each component", "[math]" )
+{
+	const auto a = Tuple(1.0f, 2.0f, 3.0f, 1.0f);
+	const auto b = Tuple(1.0f, 2.5f, 3.0f + EPSILON * 0.5f, 0.0f);
+	REQUIRE(EqualMask(a, a) == 0xF);
+	REQUIRE(EqualMask(a, b) == 0x5);
+	STATIC_REQUIRE(EqualMask(Tuple(1.0f, 2.0f, 3.0f, 1.0f), Tuple(1.0f, 2.5f, 3.0f, 0.0f)) == 0x5);
+
+	const auto c1 = Color(0.1f, 0.2f, 0.3f);
+	const auto c2 = Color(0.1f, 0.25f, 0.3f);
+	REQUIRE(EqualMask(c1, c1) == 0x7);
+	REQUIRE(EqualMask(c1, c2) == 0x5);
+	STATIC_REQUIRE(EqualMask(Color(0.1f, 0.2f, 0.3f), Color(0.1f, 0.25f, 0.3f)) == 0x5);
+}
+
+TEST_CASE( "Bulk float comparisons", "[math]" )
+{
+	std::vector<float> a(37);
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		a[i] = static_cast<float>(i) * 0.5f;
+	}
+
+	auto b = a;
+	REQUIRE(AllEqual(a.data(), b.data(), a.size()));
+	REQUIRE(CountNotEqual(a.data(), b.data(), a.size()) == 0);
+
+	b[3] += 1.0f;
+	b[20] += EPSILON * 0.5f;
+	b[36] -= 1.0f;
+	REQUIRE_FALSE(AllEqual(a.data(), b.data(), a.size()));
+	REQUIRE(AllEqual(a.data(), b.data(), 3));
+	REQUIRE(CountNotEqual(a.data(), b.data(), a.size()) == 2);
+}
+
+TEST_CASE( "The constexpr square root matches std::sqrt", "[constexpr]" )
+{
+	for (const float value : {0.0f, 1.0e-8f, 0.25f, 2.0f, 14.0f, 12345.678f, 3.0e30f})
+	{
+		REQUIRE(ConstexprSqrt(value) == Approx(std::sqrt(value)).epsilon(1.0e-7));
+		REQUIRE(ConstexprSqrt(static_cast<double>(value)) == Approx(std::sqrt(static_cast<double>(value))).epsilon(1.0e-15));
+	}
+	STATIC_REQUIRE(ConstexprSqrt(16.0f) == 4.0f);
+}
+
+TEST_CASE( "The constexpr sine and cosine match std::sin and std::cos", "[constexpr]" )
+{
+	for (const float value : {0.0f, 1.0e-6f, 0.5f, -1.0f, PI / 2.0f, 3.0f, -PI, 10.0f, 1000.0f})
+	{
+		REQUIRE(ConstexprSin(value) == Approx(std::sin(value)).margin(1.0e-7));
+		REQUIRE(ConstexprCos(value) == Approx(std::cos(value)).margin(1.0e-7));
+		const double wide = value;
+		REQUIRE(ConstexprSin(wide) == Approx(std::sin(wide)).margin(1.0e-13));
+		REQUIRE(ConstexprCos(wide) == Approx(std::cos(wide)).margin(1.0e-13));
+	}
+	STATIC_REQUIRE(ConstexprSin(0.0f) == 0.0f);
+	STATIC_REQUIRE(Equal(ConstexprSin(PI / 6.0f), 0.5f));
+	STATIC_REQUIRE(Equal(ConstexprCos(PI / 3.0f), 0.5f));
+}
+
 TEST_CASE( "Creating a canvas", "[canvas]" )
 {
     const auto c = Canvas(10, 20);
@@ -266,6 +649,23 @@ TEST_CASE( "Writing pixels to a canvas", "[canvas]" )
 	}
 }
 
+TEST_CASE( "Counting the different pixels of two canvases", "[canvas]" )
+{
+	Canvas a(7, 5);
+	Canvas b(7, 5);
+	a.Fill(Color(0.5f, 0.25f, 1.0f));
+	b.Fill(Color(0.5f, 0.25f, 1.0f));
+	REQUIRE(CountDifferentPixels(a, b) == 0);
+
+	b.WritePixel(0, 0, Color(0.0f, 0.25f, 1.0f));
+	b.WritePixel(3, 2, Color(0.5f, 0.3f, 1.0f));
+	b.WritePixel(6, 4, Color(0.5f, 0.25f, 0.0f));
+	b.WritePixel(5, 4, Color(0.5f, 0.25f, 1.0f + EPSILON * 0.5f));
+	REQUIRE(CountDifferentPixels(a, b) == 3);
+
+	REQUIRE_THROWS_AS(CountDifferentPixels(a, Canvas(5, 7)), std::invalid_argument);
+}
+
 TEST_CASE( "Constructing the PPM header", "[canvas]" )
 {
 	const Canvas c(5, 3);
@@ -368,6 +768,265 @@ TEST_CASE( "Splitting long lines in PPM files", "[canvas]" )
 	}
 }
 
+TEST_CASE( "PPM lines stay under 70 characters for values of every width", "[canvas]" )
+{
+	Canvas c(40, 3);
+	for (uint32_t y = 0; y < c.height; ++y)
+	{
+		for (uint32_t x = 0; x < c.width; ++x)
+		{
+			c.WritePixel(x, y, Color(x / 39.0f, (x % 10) / 255.0f, (y * 40 + x) % 100 / 255.0f));
+		}
+	}
+
+	std::istringstream iss(c.ToPpm());
+	std::string line;
+	for (size_t i = 0; i < 3; ++i)
+		std::getline(iss, line);
+
+	std::vector<int> values;
+	while (std::getline(iss, line))
+	{
+		REQUIRE(!line.empty());
+		REQUIRE(line.size() < 70);
+		std::istringstream lineStream(line);
+		int value = 0;
+		while (lineStream >> value)
+			values.push_back(value);
+	}
+
+	REQUIRE(values.size() == c.width * c.height * 3);
+	for (uint32_t y = 0; y < c.height; ++y)
+	{
+		for (uint32_t x = 0; x < c.width; ++x)
+		{
+			const auto pixel = c.PixelAt(x, y);
+			const size_t index = (y * c.width + x) * 3;
+			REQUIRE(values[index] == ColorFloatToUint8(pixel.r));
+			REQUIRE(values[index + 1] == ColorFloatToUint8(pixel.g));
+			REQUIRE(values[index + 2] == ColorFloatToUint8(pixel.b));
+		}
+	}
+}
+
+TEST_CASE( "Writing a binary PPM file", "[canvas]" )
+{
+	Canvas c(5, 3);
+	c.WritePixel(0, 0, Color(1.5f, 0.0f, 0.0f));
+	c.WritePixel(2, 1, Color(0.0f, 0.5f, 0.0f));
+	c.WritePixel(4, 2, Color(-0.5f, 0.0f, 1.0f));
+
+	std::string expected = "P6\n5 3\n255\n";
+	const size_t headerSize = expected.size();
+	expected.resize(headerSize + 5 * 3 * 3, '\0');
+	expected[headerSize] = static_cast<char>(255);
+	expected[headerSize + (1 * 5 + 2) * 3 + 1] = static_cast<char>(128);
+	expected[headerSize + (2 * 5 + 4) * 3 + 2] = static_cast<char>(255);
+
+	std::ostringstream stream;
+	c.WriteBinaryPpm(stream);
+	REQUIRE(stream.str() == expected);
+
+	std::FILE* file = std::tmpfile();
+	REQUIRE(file != nullptr);
+	c.WriteBinaryPpm(file);
+	std::string written(expected.size() + 1, '\0');
+	std::rewind(file);
+	written.resize(std::fread(written.data(), 1, written.size(), file));
+	std::fclose(file);
+	REQUIRE(written == expected);
+}
+
+TEST_CASE( "Writing a binary PPM larger than the write buffer", "[canvas]" )
+{
+	Canvas c(300, 200);
+	c.Fill(Color(1.0f, 0.8f, 0.6f));
+
+	std::ostringstream stream;
+	c.WriteBinaryPpm(stream);
+	const auto ppm = stream.str();
+
+	std::string expected = "P6\n300 200\n255\n";
+	for (size_t i = 0; i < 300 * 200; ++i)
+	{
+		expected += static_cast<char>(255);
+		expected += static_cast<char>(204);
+		expected += static_cast<char>(153);
+	}
+	REQUIRE(ppm == expected);
+}
+
+TEST_CASE( "Encoding PPM files on several threads", "[canvas]" )
+{
+	Canvas c(37, 11);
+	for (uint32_t y = 0; y < c.height; ++y)
+	{
+		for (uint32_t x = 0; x < c.width; ++x)
+		{
+			c.WritePixel(x, y, Color(x / 36.0f, y / 10.0f, ((x * 7 + y) % 13) / 12.0f));
+		}
+	}
+
+	const auto plain = c.ToPpm();
+	std::ostringstream binary;
+	c.WriteBinaryPpm(binary);
+
+	for (const size_t threadCount : {size_t(2), size_t(4), size_t(20), size_t(0)})
+	{
+		REQUIRE(c.ToPpm(threadCount) == plain);
+
+		std::ostringstream stream;
+		c.WriteBinaryPpm(stream, threadCount);
+		REQUIRE(stream.str() == binary.str());
+	}
+}
+
+TEST_CASE( "A tiled canvas behaves like a row-major one", "[canvas]" )
+{
+	// Not a multiple of the tile size in either direction.
+	Canvas rowMajor(21, 13);
+	Canvas tiled(21, 13, CanvasLayout::Tiled);
+	REQUIRE(tiled.pixels.size() >= tiled.width * tiled.height);
+
+	for (uint32_t y = 0; y < rowMajor.height; ++y)
+	{
+		for (uint32_t x = 0; x < rowMajor.width; ++x)
+		{
+			const Color color(x / 20.0f, y / 12.0f, 0.5f);
+			rowMajor.WritePixel(x, y, color);
+			tiled.WritePixel(x, y, color);
+		}
+	}
+
+	for (uint32_t y = 0; y < rowMajor.height; ++y)
+	{
+		for (uint32_t x = 0; x < rowMajor.width; ++x)
+		{
+			REQUIRE(tiled.PixelAt(x, y) == rowMajor.PixelAt(x, y));
+		}
+	}
+
+	REQUIRE(CountDifferentPixels(tiled, rowMajor) == 0);
+	REQUIRE(tiled.ToPpm() == rowMajor.ToPpm());
+	REQUIRE(tiled.ToPpm(3) == rowMajor.ToPpm());
+
+	std::ostringstream tiledBinary;
+	std::ostringstream rowMajorBinary;
+	tiled.WriteBinaryPpm(tiledBinary);
+	rowMajor.WriteBinaryPpm(rowMajorBinary);
+	REQUIRE(tiledBinary.str() == rowMajorBinary.str());
+
+	tiled.WritePixel(20, 12, Color(1.0f, 1.0f, 1.0f));
+	REQUIRE(CountDifferentPixels(tiled, rowMajor) == 1);
+}
+
+TEST_CASE( "Walking a canvas tile by tile", "[canvas]" )
+{
+	for (const auto layout : {CanvasLayout::RowMajor, CanvasLayout::Tiled})
+	{
+		Canvas c(19, 10, layout);
+		REQUIRE(c.TileCount() == 3 * 2);
+
+		size_t tileCount = 0;
+		size_t pixelCount = 0;
+		for (const auto tile : c.Tiles())
+		{
+			REQUIRE(tile.x % CANVAS_TILE_SIZE == 0);
+			REQUIRE(tile.y % CANVAS_TILE_SIZE == 0);
+			REQUIRE(tile.width == std::min(CANVAS_TILE_SIZE, c.width - tile.x));
+			REQUIRE(tile.height == std::min(CANVAS_TILE_SIZE, c.height - tile.y));
+			for (uint32_t y = 0; y < tile.height; ++y)
+			{
+				for (uint32_t x = 0; x < tile.width; ++x)
+				{
+					tile.At(x, y) = Color(static_cast<float>(tile.x + x), static_cast<float>(tile.y + y), 0.0f);
+				}
+			}
+
+			++tileCount;
+			pixelCount += tile.width * tile.height;
+		}
+
+		REQUIRE(tileCount == c.TileCount());
+		REQUIRE(pixelCount == c.width * c.height);
+		for (uint32_t y = 0; y < c.height; ++y)
+		{
+			for (uint32_t x = 0; x < c.width; ++x)
+			{
+				REQUIRE(c.PixelAt(x, y) == Color(static_cast<float>(x), static_cast<float>(y), 0.0f));
+			}
+		}
+
+		if (layout == CanvasLayout::Tiled)
+		{
+			for (size_t i = 0; i < c.TileCount(); ++i)
+			{
+				REQUIRE(reinterpret_cast<uintptr_t>(c.Tile(i).first) % CACHE_LINE_SIZE == 0);
+			}
+		}
+
+		const Canvas& constCanvas = c;
+		const auto last = constCanvas.Tile(constCanvas.TileCount() - 1);
+		REQUIRE(last.x == 16);
+		REQUIRE(last.y == 8);
+		REQUIRE(last.At(2, 1) == Color(18.0f, 9.0f, 0.0f));
+	}
+}
+
+TEST_CASE( "Canvas indices do not wrap around at 32 bits", "[canvas]" )
+{
+	STATIC_REQUIRE(TwoDimensionToOne(100000, 99999, 99999) == 9999999999ull);
+	STATIC_REQUIRE(TwoDimensionToOne(UINT32_MAX, UINT32_MAX - 1, UINT32_MAX - 1)
+		== static_cast<uint64_t>(UINT32_MAX) * UINT32_MAX - 1);
+}
+
+TEST_CASE( "Writing a PPM file block by block", "[canvas]" )
+{
+	const auto path = (std::filesystem::temp_directory_path() / "RayTracerTest_PpmFileCanvas.ppm").string();
+
+	Canvas expected(20, 12);
+	{
+		PpmFileCanvas file(path, 20, 12);
+		REQUIRE(file.Width() == 20);
+		REQUIRE(file.Height() == 12);
+
+		// Blocks out of order and in both layouts, the bottom right corner is never written and stays black.
+		Canvas bottom(20, 4, CanvasLayout::Tiled);
+		bottom.Fill(Color(0.0f, 0.0f, 1.0f));
+		bottom.WritePixel(19, 3, Color(0.0f, 0.0f, 0.0f));
+		file.WriteBlock(0, 8, bottom);
+
+		Canvas top(16, 8);
+		top.Fill(Color(1.0f, 0.5f, 0.0f));
+		file.WriteBlock(0, 0, top);
+
+		REQUIRE_THROWS_AS(file.WriteBlock(8, 0, top), std::out_of_range);
+		REQUIRE(file.PixelAt(3, 9) == Color(0.0f, 0.0f, 1.0f));
+		REQUIRE(file.PixelAt(18, 2) == Color(0.0f, 0.0f, 0.0f));
+		file.Flush();
+
+		for (uint32_t y = 0; y < 12; ++y)
+		{
+			for (uint32_t x = 0; x < 20; ++x)
+			{
+				if (y >= 8)
+					expected.WritePixel(x, y, bottom.PixelAt(x, y - 8));
+				else if (x < 16)
+					expected.WritePixel(x, y, top.PixelAt(x, y));
+			}
+		}
+	}
+
+	std::ostringstream expectedPpm;
+	expected.WriteBinaryPpm(expectedPpm);
+
+	std::ifstream written(path, std::ios::binary);
+	const std::string writtenPpm((std::istreambuf_iterator<char>(written)), std::istreambuf_iterator<char>());
+	written.close();
+	std::filesystem::remove(path);
+	REQUIRE(writtenPpm == expectedPpm.str());
+}
+
 TEST_CASE( "Constructing and inspecting a 4x4 matrix", "[matrix]" )
 {
 	float els[4][4] = {
@@ -376,7 +1035,7 @@ TEST_CASE( "Constructing and inspecting a 4x4 matrix", "[matrix]" )
 		{9.0f, 10.0f, 11.0f, 12.0f},
 		{13.5f, 14.5f, 15.5f, 16.5f},
 	};
-	const Matrix4x4 m(els);
+	Matrix4x4 m(els);
 
 	REQUIRE(Equal(m[0][0], 1.0f));
 	REQUIRE(Equal(m[0][3], 4.0f));
@@ -387,7 +1046,7 @@ TEST_CASE( "Constructing and inspecting a 4x4 matrix", "[matrix]" )
 	REQUIRE(Equal(m[3][2], 15.5f));
 
 	m[3][2] = 12.6f;
-	Equal(m[3][2], 12.6f);
+	REQUIRE(Equal(m[3][2], 12.6f));
 }
 
 TEST_CASE( "Constructing and inspecting a 2x2 matrix", "[matrix]" )
@@ -648,6 +1307,41 @@ TEST_CASE( "Calculate the determinant of a 4x4 matrix", "[matrix]" )
 	REQUIRE(Equal(a.Determinant(), -4071.0f));
 }
 
+TEST_CASE( "Calculate the determinant of a 5x5 matrix", "[matrix]" )
+{
+	// A zero in the first pivot position, so the elimination has to swap rows.
+	constexpr Matrix<5, double> a(Matrix<5, double>::MatrixElementsType{{
+		{ 0.0,  2.0, -1.0,  3.0,  1.0},
+		{ 4.0,  1.0,  0.0, -2.0,  5.0},
+		{-3.0,  6.0,  2.0,  1.0,  0.0},
+		{ 1.0,  0.0,  4.0, -1.0,  2.0},
+		{ 2.0, -5.0,  1.0,  0.0,  3.0},
+	}});
+
+	STATIC_REQUIRE(Equal(a.Determinant(), -942.0));
+	REQUIRE(Equal(a.Determinant(), -942.0));
+
+	double expansion = 0.0;
+	for (size_t col = 0; col < 5; ++col)
+	{
+		expansion += a[0][col] * a.Cofactor(0, col);
+	}
+	REQUIRE(Equal(a.Determinant(), expansion));
+	REQUIRE(a.IsInvertible());
+
+	// The second row is twice the first.
+	const Matrix<5, double> singular(Matrix<5, double>::MatrixElementsType{{
+		{1.0, 2.0, 3.0, 4.0,  5.0},
+		{2.0, 4.0, 6.0, 8.0, 10.0},
+		{0.0, 1.0, 0.0, 1.0,  0.0},
+		{3.0, 1.0, 4.0, 1.0,  5.0},
+		{9.0, 2.0, 6.0, 5.0,  3.0},
+	}});
+
+	REQUIRE(Equal(singular.Determinant(), 0.0));
+	REQUIRE_FALSE(singular.IsInvertible());
+}
+
 TEST_CASE( "Testing an invertible matrix for invertibility", "[matrix]" )
 {
 	const Matrix4x4 a = Make4x4Matrix({
@@ -756,3 +1450,554 @@ TEST_CASE( "Multiplying a product by it's inverse", "[matrix]" )
 	const auto c = a * b;
 	REQUIRE((c * b.Inverse()) == a);
 }
+
+TEST_CASE( "Multiplying a matrix and typed points and vectors", "[matrix]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		1.0f, 2.0f, 3.0f, 4.0f,
+		2.0f, 4.0f, 4.0f, 2.0f,
+		8.0f, 6.0f, 4.0f, 1.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+
+	const Point3 p(1.0f, 2.0f, 3.0f);
+	const Vector3 v(1.0f, 2.0f, 3.0f);
+
+	REQUIRE((a * p) == Point3(18.0f, 24.0f, 33.0f));
+	REQUIRE((a * p).ToTuple() == a * p.ToTuple());
+	REQUIRE((a * v) == Vector3(14.0f, 22.0f, 32.0f));
+	REQUIRE((a * v).ToTuple() == a * v.ToTuple());
+	REQUIRE((a * Normal3(v)) == Normal3(14.0f, 22.0f, 32.0f));
+}
+
+TEST_CASE( "Double precision tuples keep small offsets at large coordinates", "[tuple][double]" )
+{
+	const auto a = Tupled::CreatePoint(1.0e6, 2.0e6, -3.0e6);
+	const auto offset = Tupled::CreateVector(0.001, 0.002, 0.003);
+
+	const Tupled b = a + offset;
+	REQUIRE((b - a) == offset);
+	REQUIRE(Equal(Dot(offset, offset), 0.000014));
+	REQUIRE(Cross(Tupled::CreateVector(1, 0, 0), Tupled::CreateVector(0, 1, 0)) == Tupled::CreateVector(0, 0, 1));
+	REQUIRE(Tupled::CreateVector(4, 0, 0).Normalize() == Tupled::CreateVector(1, 0, 0));
+	REQUIRE((offset * 2) == Tupled::CreateVector(0.002, 0.004, 0.006));
+	REQUIRE_THROWS_AS(Add<CheckedTupleArithmetic>(a, a), std::invalid_argument);
+	REQUIRE(ToString(Tupled::CreatePoint(1, 2, 3)) == "Point {1, 2, 3, 1}");
+
+	std::vector<Tupled> vectors = {Tupled::CreateVector(0, 3, 0), Tupled::CreateVector(0, 0, 2)};
+	NormalizeMany(vectors.data(), vectors.size());
+	REQUIRE(vectors[0] == Tupled::CreateVector(0, 1, 0));
+	REQUIRE(vectors[1] == Tupled::CreateVector(0, 0, 1));
+}
+
+TEST_CASE( "Double precision comparisons use a tighter tolerance", "[math][double]" )
+{
+	STATIC_REQUIRE(EPSILON == Epsilon<float>);
+	STATIC_REQUIRE(Epsilon<double> < static_cast<double>(Epsilon<float>));
+
+	// Apart by less than the float tolerance but far more than the double one.
+	const double offset = static_cast<double>(EPSILON) * 0.1;
+	REQUIRE(Equal(1.0f, 1.0f + static_cast<float>(offset)));
+	REQUIRE_FALSE(Equal(1.0, 1.0 + offset));
+	REQUIRE(Equal(1.0, 1.0 + Epsilon<double> * 0.5));
+
+	REQUIRE(Tupled::CreatePoint(1, 2, 3) != Tupled::CreatePoint(1, 2, 3 + offset));
+	REQUIRE(Colord(0.5, 0.5, 0.5) != Colord(0.5, 0.5 + offset, 0.5));
+	REQUIRE(Matrix4x4d::Identity() != Make4x4Matrix<double>({
+		1, 0, 0, offset,
+		0, 1, 0, 0,
+		0, 0, 1, 0,
+		0, 0, 0, 1,
+	}));
+	REQUIRE(Tuple::CreatePoint(1, 2, 3) == Tuple::CreatePoint(1, 2, 3 + static_cast<float>(offset)));
+}
+
+TEST_CASE( "Double precision colors", "[color][double]" )
+{
+	const Colord a(0.9, 0.6, 0.75);
+	const Colord b(0.7, 0.1, 0.25);
+
+	REQUIRE((a + b) == Colord(1.6, 0.7, 1.0));
+	REQUIRE((a * 2) == Colord(1.8, 1.2, 1.5));
+	REQUIRE((a * b) == Colord(0.63, 0.06, 0.1875));
+	REQUIRE(EqualMask(a, Colord(0.9, 0.0, 0.75)) == 0x5);
+}
+
+TEST_CASE( "Double precision matrices", "[matrix][double]" )
+{
+	const Matrix4x4d a = Make4x4Matrix<double>({
+		3, -9, 7, 3,
+		3, -8, 2, -9,
+		-4, 4, 4, 1,
+		-6, 5, -1, 1,
+	});
+	const Matrix4x4d b = Make4x4Matrix<double>({
+		8, 2, 2, 2,
+		3, -1, 7, 0,
+		7, 0, 5, 4,
+		6, -2, 0, 5,
+	});
+
+	REQUIRE(Equal(Make2x2Matrix<double>({1, 5, -3, 2}).Determinant(), 17.0));
+	REQUIRE(((a * b) * b.Inverse()) == a);
+	REQUIRE((a * a.Inverse()) == Matrix4x4d::Identity());
+	REQUIRE((Matrix4x4d::Identity() * Tupled::CreatePoint(1, 2, 3)) == Tupled::CreatePoint(1, 2, 3));
+}
+
+TEST_CASE( "Transforming arrays of points and vectors", "[matrix]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		1.0f, 2.0f, 3.0f, 4.0f,
+		2.0f, 4.0f, 4.0f, 2.0f,
+		8.0f, 6.0f, 4.0f, 1.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+
+	std::vector<Tuple> points;
+	std::vector<Tuple> vectors;
+	for (int i = 0; i < 7; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		points.push_back(Tuple::CreatePoint(f, 1.0f - f, 0.5f * f));
+		vectors.push_back(Tuple::CreateVector(-f, 2.0f, f * f));
+	}
+
+	std::vector<Tuple> transformed(points.size());
+	TransformPoints(a, points.data(), transformed.data(), points.size());
+	for (size_t i = 0; i < points.size(); ++i)
+		REQUIRE(transformed[i] == a * points[i]);
+
+	TransformVectors(a, vectors.data(), vectors.data(), vectors.size());
+	for (int i = 0; i < 7; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		REQUIRE(vectors[i] == a * Tuple::CreateVector(-f, 2.0f, f * f));
+	}
+}
+
+TEMPLATE_TEST_CASE( "Transforming packets of points and vectors", "[matrix][packet]", TuplePacket4, TuplePacket8 )
+{
+	constexpr size_t width = TestType::WIDTH;
+	const Matrix4x4 a = Make4x4Matrix({
+		1.0f, 2.0f, 3.0f, 4.0f,
+		2.0f, 4.0f, 4.0f, 2.0f,
+		8.0f, 6.0f, 4.0f, 1.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+
+	std::vector<Tuple> points;
+	std::vector<Tuple> vectors;
+	for (size_t i = 0; i < 2 * width; ++i)
+	{
+		const auto f = static_cast<float>(i);
+		points.push_back(Tuple::CreatePoint(f, 1.0f - f, 0.5f * f));
+		vectors.push_back(Tuple::CreateVector(-f, 2.0f, f * f));
+	}
+
+	const TestType pointPackets[2] = {TestType::Load(points.data()), TestType::Load(points.data() + width)};
+	const TestType vectorPackets[2] = {TestType::Load(vectors.data()), TestType::Load(vectors.data() + width)};
+	TestType transformedPoints[2];
+	TestType transformedVectors[2];
+	TransformPoints(a, pointPackets, transformedPoints, 2);
+	TransformVectors(a, vectorPackets, transformedVectors, 2);
+
+	for (size_t i = 0; i < 2 * width; ++i)
+	{
+		REQUIRE(transformedPoints[i / width].Get(i % width) == a * points[i]);
+		REQUIRE(transformedVectors[i / width].Get(i % width) == a * vectors[i]);
+	}
+}
+
+TEST_CASE( "The 4x4 inverse matches the cofactor expansion", "[matrix]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		-5.0f, 2.0f, 6.0f, -8.0f,
+		1.0f, -5.0f, 1.0f, 8.0f,
+		7.0f, 7.0f, -6.0f, -7.0f,
+		1.0f, -3.0f, 7.0f, 4.0f,
+	});
+
+	Matrix4x4::MatrixElementsType cofactors = {};
+	const float determinant = a.Submatrix(0, 0).Determinant() * a[0][0] - a.Submatrix(0, 1).Determinant() * a[0][1]
+		+ a.Submatrix(0, 2).Determinant() * a[0][2] - a.Submatrix(0, 3).Determinant() * a[0][3];
+	for (size_t row = 0; row < 4; ++row)
+	{
+		for (size_t col = 0; col < 4; ++col)
+			cofactors[col][row] = a.Cofactor(row, col) / determinant;
+	}
+
+	REQUIRE(a.Determinant() == Approx(determinant));
+	REQUIRE(a.Inverse() == Matrix4x4(cofactors));
+	REQUIRE(Inverse4x4(a) == Matrix4x4(cofactors));
+	REQUIRE(Matrix4x4::Identity().Inverse() == Matrix4x4::Identity());
+}
+
+TEST_CASE( "Calculating the inverse of a 5x5 matrix", "[matrix]" )
+{
+	Matrix<5>::MatrixElementsType elements = {{
+		{0.0f, 2.0f, 1.0f, 0.0f, 3.0f},
+		{1.0f, 0.0f, 0.0f, 2.0f, 1.0f},
+		{4.0f, 1.0f, 3.0f, 0.0f, 0.0f},
+		{0.0f, 0.0f, 1.0f, 1.0f, 2.0f},
+		{2.0f, 1.0f, 0.0f, 0.0f, 1.0f},
+	}};
+	const Matrix<5> a(elements);
+	const Matrix<5> inverse = a.Inverse();
+
+	REQUIRE((a * inverse) == Matrix<5>::Identity());
+	REQUIRE((inverse * a) == Matrix<5>::Identity());
+}
+
+TEST_CASE( "Multiplying 3x3 matrices", "[matrix]" )
+{
+	const Matrix3x3 a = Make3x3Matrix({
+		1.0f, 2.0f, 3.0f,
+		0.0f, -1.0f, 4.0f,
+		5.0f, 6.0f, 0.0f,
+	});
+	const Matrix3x3 b = Make3x3Matrix({
+		2.0f, 0.0f, 1.0f,
+		1.0f, 3.0f, -2.0f,
+		0.0f, 4.0f, 1.0f,
+	});
+
+	REQUIRE((a * b) == Make3x3Matrix({
+		4.0f, 18.0f, 0.0f,
+		-1.0f, 13.0f, 6.0f,
+		16.0f, 18.0f, -7.0f,
+	}));
+	REQUIRE((a * Matrix3x3::Identity()) == a);
+}
+
+TEST_CASE( "Converting between affine transforms and 4x4 matrices", "[affine]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		1.0f, 2.0f, 3.0f, 4.0f,
+		2.0f, 4.0f, 4.0f, 2.0f,
+		8.0f, 6.0f, 4.0f, 1.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+
+	const AffineTransform affine(a);
+	REQUIRE(affine.ToMatrix() == a);
+	REQUIRE(AffineTransform::Identity().ToMatrix() == Matrix4x4::Identity());
+	REQUIRE(affine.Determinant() == Approx(a.Determinant()));
+	REQUIRE(sizeof(AffineTransform) == 48);
+}
+
+TEST_CASE( "Composing and inverting affine transforms", "[affine]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		2.0f, 0.0f, 1.0f, 3.0f,
+		0.0f, 1.0f, -1.0f, -2.0f,
+		1.0f, 3.0f, 0.5f, 5.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+	const Matrix4x4 b = Make4x4Matrix({
+		0.0f, -1.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 2.0f, -4.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+
+	const AffineTransform affineA(a);
+	const AffineTransform affineB(b);
+
+	REQUIRE((affineA * affineB) == AffineTransform(a * b));
+	REQUIRE(affineA.Inverse() == AffineTransform(a.Inverse()));
+	REQUIRE((affineA * affineA.Inverse()) == AffineTransform::Identity());
+	REQUIRE(affineA.IsInvertible());
+}
+
+TEST_CASE( "Transforming points, vectors and normals with an affine transform", "[affine]" )
+{
+	const Matrix4x4 a = Make4x4Matrix({
+		2.0f, 0.0f, 1.0f, 3.0f,
+		0.0f, 1.0f, -1.0f, -2.0f,
+		1.0f, 3.0f, 0.5f, 5.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	});
+	const AffineTransform affine(a);
+
+	const auto p = Tuple::CreatePoint(1.0f, -2.0f, 3.0f);
+	const auto v = Tuple::CreateVector(1.0f, -2.0f, 3.0f);
+	REQUIRE((affine * p) == a * p);
+	REQUIRE((affine * v) == a * v);
+	REQUIRE((affine * Point3(1.0f, -2.0f, 3.0f)) == (a * Point3(1.0f, -2.0f, 3.0f)));
+	REQUIRE((affine * Vector3(1.0f, -2.0f, 3.0f)) == (a * Vector3(1.0f, -2.0f, 3.0f)));
+
+	const Normal3 n(0.0f, 1.0f, 0.0f);
+	REQUIRE(TransformNormal(affine.Inverse(), n) == (a.Inverse().Transpose() * n));
+}
+
+TEST_CASE( "Transformation matrices move points and vectors", "[transform]" )
+{
+	const auto p = Tuple::CreatePoint(-3.0f, 4.0f, 5.0f);
+	const auto v = Tuple::CreateVector(-3.0f, 4.0f, 5.0f);
+
+	REQUIRE((Translation(5.0f, -3.0f, 2.0f) * p) == Tuple::CreatePoint(2.0f, 1.0f, 7.0f));
+	REQUIRE((Translation(5.0f, -3.0f, 2.0f) * v) == v);
+	REQUIRE((Scaling(2.0f, 3.0f, 4.0f) * p) == Tuple::CreatePoint(-6.0f, 12.0f, 20.0f));
+	REQUIRE((Scaling(-1.0f, 1.0f, 1.0f) * v) == Tuple::CreateVector(3.0f, 4.0f, 5.0f));
+
+	const float halfQuarter = PI / 4.0f;
+	const float halfSqrt2 = std::sqrt(2.0f) / 2.0f;
+	REQUIRE((RotationX(halfQuarter) * Tuple::CreatePoint(0.0f, 1.0f, 0.0f)) == Tuple::CreatePoint(0.0f, halfSqrt2, halfSqrt2));
+	REQUIRE((RotationY(halfQuarter) * Tuple::CreatePoint(0.0f, 0.0f, 1.0f)) == Tuple::CreatePoint(halfSqrt2, 0.0f, halfSqrt2));
+	REQUIRE((RotationZ(halfQuarter) * Tuple::CreatePoint(0.0f, 1.0f, 0.0f)) == Tuple::CreatePoint(-halfSqrt2, halfSqrt2, 0.0f));
+	REQUIRE((Shearing(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f) * Tuple::CreatePoint(2.0f, 3.0f, 4.0f)) == Tuple::CreatePoint(5.0f, 3.0f, 4.0f));
+	REQUIRE((Shearing(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f) * Tuple::CreatePoint(2.0f, 3.0f, 4.0f)) == Tuple::CreatePoint(2.0f, 3.0f, 7.0f));
+}
+
+TEST_CASE( "Chained transform builders apply in sequence", "[transform]" )
+{
+	const Transform transform = Transform()
+		.RotateX(PI / 2.0f)
+		.Scale(5.0f, 5.0f, 5.0f)
+		.Translate(10.0f, 5.0f, 7.0f);
+
+	REQUIRE((transform.GetMatrix() * Tuple::CreatePoint(1.0f, 0.0f, 1.0f)) == Tuple::CreatePoint(15.0f, 0.0f, 7.0f));
+	REQUIRE(transform.GetMatrix() == Translation(10.0f, 5.0f, 7.0f) * Scaling(5.0f, 5.0f, 5.0f) * RotationX(PI / 2.0f));
+	REQUIRE(transform.ToObjectSpace(Point3(15.0f, 0.0f, 7.0f)) == Point3(1.0f, 0.0f, 1.0f));
+}
+
+TEST_CASE( "A transform caches its inverse until it changes", "[transform]" )
+{
+	Transform transform(Translation(5.0f, -3.0f, 2.0f));
+	REQUIRE(transform.GetInverse() == Translation(-5.0f, 3.0f, -2.0f));
+	REQUIRE(transform.GetInverseTranspose() == Translation(-5.0f, 3.0f, -2.0f).Transpose());
+
+	transform.Scale(2.0f, 2.0f, 2.0f);
+	REQUIRE(transform.GetInverse() == transform.GetMatrix().Inverse());
+	REQUIRE((transform.GetMatrix() * transform.GetInverse()) == Matrix4x4::Identity());
+
+	transform.SetMatrix(Scaling(1.0f, 0.5f, 1.0f));
+	REQUIRE(transform.ToWorldSpace(Normal3(0.0f, 1.0f, 0.0f)) == Normal3(0.0f, 2.0f, 0.0f));
+	REQUIRE(Transform().GetInverse() == Matrix4x4::Identity());
+}
+
+TEST_CASE( "Matrix element accessors share the matrix storage", "[matrix]" )
+{
+	Matrix4x4 a = Make4x4Matrix({
+		1.0f, 2.0f, 3.0f, 4.0f,
+		5.5f, 6.5f, 7.5f, 8.5f,
+		9.0f, 10.0f, 11.0f, 12.0f,
+		13.5f, 14.5f, 15.5f, 16.5f,
+	});
+	const Matrix4x4& constA = a;
+
+	STATIC_REQUIRE(std::is_same_v<decltype(constA[0]), const Matrix4x4::MatrixRowType&>);
+	REQUIRE(&constA[1][2] == &constA(1, 2));
+	REQUIRE(constA(1, 2) == 7.5f);
+	REQUIRE(constA.data()[4 * 3 + 1] == 14.5f);
+
+	a(3, 1) = -1.0f;
+	REQUIRE(constA[3][1] == -1.0f);
+	a.data()[0] = 2.0f;
+	REQUIRE(constA(0, 0) == 2.0f);
+}
+
+TEST_CASE( "Matrices are usable in constant expressions", "[matrix][constexpr]" )
+{
+	constexpr Matrix4x4 transform = Translation(10.0f, 5.0f, 7.0f) * Scaling(5.0f, 5.0f, 5.0f)
+		* Shearing(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	constexpr Matrix4x4 inverse = transform.Inverse();
+
+	STATIC_REQUIRE((transform * Tuple::CreatePoint(1.0f, 0.0f, 1.0f)) == Tuple::CreatePoint(15.0f, 5.0f, 12.0f));
+	STATIC_REQUIRE((transform * Point3(1.0f, 0.0f, 1.0f)) == Point3(15.0f, 5.0f, 12.0f));
+	STATIC_REQUIRE((inverse * Point3(15.0f, 5.0f, 12.0f)) == Point3(1.0f, 0.0f, 1.0f));
+	STATIC_REQUIRE((transform * inverse) == Matrix4x4::Identity());
+	STATIC_REQUIRE(transform.Transpose().Transpose() == transform);
+	STATIC_REQUIRE(transform.Determinant() == 125.0f);
+	STATIC_REQUIRE(Make2x2Matrix({1.0f, 5.0f, -3.0f, 2.0f}).Determinant() == 17.0f);
+	STATIC_REQUIRE(Make3x3Matrix({1.0f, 2.0f, 6.0f, -5.0f, 8.0f, -4.0f, 2.0f, 6.0f, 4.0f}).Determinant() == -196.0f);
+	STATIC_REQUIRE(Matrix<5>::Identity().Inverse() == Matrix<5>::Identity());
+
+	REQUIRE(inverse == transform.Inverse());
+}
+
+TEST_CASE( "Rotations are usable in constant expressions", "[matrix][constexpr]" )
+{
+	constexpr Matrix4x4 rotation = RotationZ(PI / 2.0f) * RotationY(PI / 2.0f) * RotationX(PI / 2.0f);
+
+	STATIC_REQUIRE((RotationX(PI / 2.0f) * Point3(0.0f, 1.0f, 0.0f)) == Point3(0.0f, 0.0f, 1.0f));
+	STATIC_REQUIRE((RotationY(PI / 2.0f) * Point3(0.0f, 0.0f, 1.0f)) == Point3(1.0f, 0.0f, 0.0f));
+	STATIC_REQUIRE((RotationZ(PI / 2.0f) * Point3(0.0f, 1.0f, 0.0f)) == Point3(-1.0f, 0.0f, 0.0f));
+	STATIC_REQUIRE((rotation * rotation.Transpose()) == Matrix4x4::Identity());
+
+	const float angle = PI / 2.0f;
+	REQUIRE(rotation == RotationZ(angle) * RotationY(angle) * RotationX(angle));
+}
+
+TEST_CASE( "Lazy matrix chains match eager products", "[matrix][lazy]" )
+{
+	const Matrix4x4 a = RotationX(PI / 2.0f);
+	const Matrix4x4 b = Scaling(5.0f, 5.0f, 5.0f);
+	const Matrix4x4 c = Translation(10.0f, 5.0f, 7.0f);
+	const auto p = Tuple::CreatePoint(1.0f, 0.0f, 1.0f);
+
+	REQUIRE((Lazy(c) * Lazy(b) * Lazy(a) * p) == Tuple::CreatePoint(15.0f, 0.0f, 7.0f));
+	REQUIRE((Lazy(c) * (Lazy(b) * Lazy(a)) * p) == (c * b * a * p));
+	REQUIRE((Lazy(c) * Lazy(b) * Lazy(a) * Point3(1.0f, 0.0f, 1.0f)) == Point3(15.0f, 0.0f, 7.0f));
+	REQUIRE((Lazy(c) * Lazy(b) * Lazy(a) * Vector3(0.0f, 1.0f, 0.0f)) == (c * b * a * Vector3(0.0f, 1.0f, 0.0f)));
+
+	const Matrix4x4 composed = Lazy(c) * Lazy(b) * Lazy(a);
+	REQUIRE(composed == c * b * a);
+	REQUIRE((Lazy(c) * Lazy(b)).Evaluate() == c * b);
+
+	constexpr Matrix4x4 translation = Translation(1.0f, 2.0f, 3.0f);
+	constexpr Matrix4x4 scaling = Scaling(2.0f, 2.0f, 2.0f);
+	STATIC_REQUIRE((Lazy(translation) * Lazy(scaling) * Tuple::CreatePoint(1.0f, 1.0f, 1.0f)) == Tuple::CreatePoint(3.0f, 4.0f, 5.0f));
+}
+
+TEST_CASE( "Quaternions rotate like the rotation matrices", "[quaternion]" )
+{
+	const auto xAxis = Tuple::CreateVector(1.0f, 0.0f, 0.0f);
+	const auto yAxis = Tuple::CreateVector(0.0f, 1.0f, 0.0f);
+	const auto zAxis = Tuple::CreateVector(0.0f, 0.0f, 1.0f);
+	const auto p = Tuple::CreatePoint(1.0f, 2.0f, 3.0f);
+	const auto v = Tuple::CreateVector(-2.0f, 0.5f, 1.0f);
+
+	const Quaternion rx = Quaternion::FromAxisAngle(xAxis, PI / 3.0f);
+	const Quaternion ry = Quaternion::FromAxisAngle(yAxis, -PI / 4.0f);
+	const Quaternion rz = Quaternion::FromAxisAngle(zAxis * 3.0f, PI / 2.0f);
+
+	REQUIRE((rx * p) == (RotationX(PI / 3.0f) * p));
+	REQUIRE((ry * v) == (RotationY(-PI / 4.0f) * v));
+	REQUIRE((rz * p) == (RotationZ(PI / 2.0f) * p));
+	REQUIRE((rz * Point3(1.0f, 0.0f, 0.0f)) == Point3(0.0f, 1.0f, 0.0f));
+	REQUIRE((rz * Vector3(1.0f, 0.0f, 0.0f)) == Vector3(0.0f, 1.0f, 0.0f));
+	REQUIRE((Quaternion::Identity() * p) == p);
+	REQUIRE((rx.Inverse() * (rx * p)) == p);
+}
+
+TEST_CASE( "Composing quaternions matches composing matrices", "[quaternion]" )
+{
+	const Quaternion a = Quaternion::FromAxisAngle(Tuple::CreateVector(1.0f, 1.0f, 0.0f), 0.7f);
+	const Quaternion b = Quaternion::FromAxisAngle(Tuple::CreateVector(0.0f, 1.0f, -2.0f), -1.3f);
+	const auto p = Tuple::CreatePoint(1.0f, 2.0f, 3.0f);
+
+	REQUIRE((a * b).ToMatrix() == a.ToMatrix() * b.ToMatrix());
+	REQUIRE(((a * b) * p) == (a * (b * p)));
+	REQUIRE((a * b).Magnitude() == Approx(1.0f));
+	REQUIRE((a * b).ToAffine() == AffineTransform(a.ToMatrix() * b.ToMatrix()));
+}
+
+TEST_CASE( "Converting between quaternions and matrices", "[quaternion]" )
+{
+	const Quaternion rotations[] = {
+		Quaternion::FromAxisAngle(Tuple::CreateVector(1.0f, 0.0f, 0.0f), PI),
+		Quaternion::FromAxisAngle(Tuple::CreateVector(0.0f, 1.0f, 0.0f), PI * 0.99f),
+		Quaternion::FromAxisAngle(Tuple::CreateVector(0.0f, 0.0f, 1.0f), -PI * 0.9f),
+		Quaternion::FromAxisAngle(Tuple::CreateVector(1.0f, -2.0f, 0.5f), 0.4f),
+	};
+
+	for (const auto& rotation : rotations)
+	{
+		const Quaternion converted = Quaternion::FromMatrix(rotation.ToMatrix());
+		REQUIRE((converted == rotation || converted == Quaternion(-rotation.x, -rotation.y, -rotation.z, -rotation.w)));
+		REQUIRE(Quaternion::FromAffine(rotation.ToAffine()).ToMatrix() == rotation.ToMatrix());
+	}
+}
+
+TEST_CASE( "Interpolating quaternions", "[quaternion]" )
+{
+	const auto yAxis = Tuple::CreateVector(0.0f, 1.0f, 0.0f);
+	const Quaternion from = Quaternion::Identity();
+	const Quaternion to = Quaternion::FromAxisAngle(yAxis, PI / 2.0f);
+	const Quaternion halfway = Quaternion::FromAxisAngle(yAxis, PI / 4.0f);
+
+	REQUIRE(Slerp(from, to, 0.0f) == from);
+	REQUIRE(Slerp(from, to, 1.0f) == to);
+	REQUIRE(Slerp(from, to, 0.5f) == halfway);
+	REQUIRE(Slerp(from, to, 0.25f) == Quaternion::FromAxisAngle(yAxis, PI / 8.0f));
+	REQUIRE(Nlerp(from, to, 0.5f) == halfway);
+	REQUIRE(Nlerp(from, to, 0.3f).Magnitude() == Approx(1.0f));
+
+	const Quaternion negatedTo(-to.x, -to.y, -to.z, -to.w);
+	REQUIRE(Slerp(from, negatedTo, 0.5f) == halfway);
+	REQUIRE(Slerp(to, to, 0.5f) == to);
+}
+
+TEST_CASE( "A transform stack composes parent and child transforms", "[transform]" )
+{
+	TransformStack stack;
+	REQUIRE(stack.Depth() == 1);
+	REQUIRE(stack.World() == Matrix4x4::Identity());
+
+	stack.Multiply(Translation(1.0f, 2.0f, 3.0f));
+	stack.Push();
+	stack.Multiply(Scaling(2.0f, 2.0f, 2.0f));
+	REQUIRE(stack.Depth() == 2);
+	REQUIRE(stack.World() == Translation(1.0f, 2.0f, 3.0f) * Scaling(2.0f, 2.0f, 2.0f));
+	REQUIRE((stack.World() * Tuple::CreatePoint(1.0f, 1.0f, 1.0f)) == Tuple::CreatePoint(3.0f, 4.0f, 5.0f));
+	REQUIRE((stack.WorldInverse() * Tuple::CreatePoint(3.0f, 4.0f, 5.0f)) == Tuple::CreatePoint(1.0f, 1.0f, 1.0f));
+
+	stack.Pop();
+	REQUIRE(stack.World() == Translation(1.0f, 2.0f, 3.0f));
+	REQUIRE(stack.WorldInverse() == Translation(-1.0f, -2.0f, -3.0f));
+}
+
+TEST_CASE( "Flattening a transform hierarchy", "[transform]" )
+{
+	TransformNode root;
+	root.local = RotationY(PI / 2.0f);
+
+	TransformNode group;
+	group.local = Scaling(2.0f, 2.0f, 2.0f);
+
+	TransformNode sphere;
+	sphere.local = Translation(5.0f, 0.0f, 0.0f);
+	sphere.leafIndex = 7;
+	group.children.push_back(sphere);
+
+	TransformNode cube;
+	cube.leafIndex = 3;
+	root.children.push_back(group);
+	root.children.push_back(cube);
+
+	const auto leaves = FlattenHierarchy(root);
+	REQUIRE(leaves.size() == 2);
+
+	REQUIRE(leaves[0].leafIndex == 7);
+	REQUIRE(leaves[0].world.GetMatrix() == RotationY(PI / 2.0f) * Scaling(2.0f, 2.0f, 2.0f) * Translation(5.0f, 0.0f, 0.0f));
+	REQUIRE((leaves[0].world.GetMatrix() * Tuple::CreatePoint(0.0f, 0.0f, 0.0f)) == Tuple::CreatePoint(0.0f, 0.0f, -10.0f));
+	REQUIRE((leaves[0].world.GetMatrix() * leaves[0].world.GetInverse()) == Matrix4x4::Identity());
+
+	REQUIRE(leaves[1].leafIndex == 3);
+	REQUIRE(leaves[1].world.GetMatrix() == RotationY(PI / 2.0f));
+}
+
+TEST_CASE( "Inverting and composing batches of matrices", "[matrix]" )
+{
+	// Not a multiple of the thread count, so the chunks differ in size.
+	std::vector<Matrix4x4> matrices;
+	for (int i = 0; i < 21; ++i)
+	{
+		const float f = static_cast<float>(i);
+		matrices.push_back(Translation(0.5f * f, -2.0f, 1.0f) * RotationY(0.1f * f) * Scaling(1.0f + 0.1f * f, 2.0f, 0.5f)
+			* Shearing(0.0f, 0.1f * f, 0.0f, 0.0f, 0.2f, 0.0f));
+	}
+
+	for (const size_t threadCount : {size_t(1), size_t(3), size_t(0)})
+	{
+		std::vector<Matrix4x4> inverses(matrices.size(), Matrix4x4::Identity());
+		InvertMatrices(matrices.data(), inverses.data(), matrices.size(), threadCount);
+
+		std::vector<Matrix4x4> products(matrices.size(), Matrix4x4::Identity());
+		ComposeMatrices(matrices.data(), inverses.data(), products.data(), matrices.size(), threadCount);
+
+		for (size_t i = 0; i < matrices.size(); ++i)
+		{
+			REQUIRE(inverses[i] == matrices[i].Inverse());
+			REQUIRE(products[i] == matrices[i] * inverses[i]);
+		}
+	}
+
+	std::vector<Matrix4x4> inPlace = matrices;
+	ComposeMatrices(inPlace.data(), matrices.data(), inPlace.data(), inPlace.size());
+	for (size_t i = 0; i < matrices.size(); ++i)
+	{
+		REQUIRE(inPlace[i] == matrices[i] * matrices[i]);
+	}
+}
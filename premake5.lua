@@ -21,6 +21,11 @@ filter { "configurations:Release" }
     defines { "NDEBUG" }
     optimize "Full"
 
+filter "system:linux"
+    links { "pthread" }
+
+filter {}
+
 project "RayTracer"
     kind "ConsoleApp"
     files { "RayTracer/**.h", "RayTracer/**.cpp" }
@@ -33,6 +38,13 @@ project "RayTracerTest"
     links { "RayTracerLib" }
     includedirs { "RayTracerLib/include", "ThirdParty/Catch2/include" }
 
+project "RayTracerBench"
+    kind "ConsoleApp"
+    files { "RayTracerBench/**.h", "RayTracerBench/**.cpp" }
+    links { "RayTracerLib" }
+    includedirs { "RayTracerLib/include", "ThirdParty/Catch2/include" }
+    defines { "CATCH_CONFIG_ENABLE_BENCHMARKING" }
+
 project "RayTracerLib"
     kind "StaticLib"
     files { "RayTracerLib/include/RayTracerLib/**.h", "RayTracerLib/src/**.cpp" }